@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "../include/path_finder.h"
+#include "../include/priority_queue.h"
+#include "../include/scheduler.h"
+
+// Runs fixed query sets on seeded synthetic maps, so two builds can be compared run to run
+// built by 'make bench' with PATH_FINDER_STATS for the expanded nodes,
+// and with the allocator wrapped by the linker to count the allocations of the search
+
+#ifndef PATH_FINDER_STATS
+#error "the benchmark needs the search stats, build it with -DPATH_FINDER_STATS"
+#endif
+
+// the allocator calls made since the start, counted by the wrappers below
+static long long nb_allocs;
+static long long nb_frees;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    nb_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    nb_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    nb_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if(ptr != NULL)
+        nb_frees++;
+    __real_free(ptr);
+}
+
+// a small seeded generator, so the maps and queries are the same on every machine
+static uint64_t rng_state;
+
+static void seed(uint64_t s)
+{
+    rng_state = s * 0x9E3779B97F4A7C15ull + 1;
+}
+
+static uint32_t next_random()
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t) ((rng_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// the kinds of maps the benchmark runs on
+typedef enum Map_Kind {
+    MAP_OPEN,
+    MAP_RANDOM_10,
+    MAP_RANDOM_20,
+    MAP_RANDOM_30,
+    MAP_MAZE,
+    MAP_ROOMS
+} Map_Kind;
+
+static const char *map_names[] = {"open", "random10", "random20", "random30", "maze", "rooms"};
+
+// carves a maze with corridors one cell wide, every cell at odd coordinates is connected to the others
+static void carve_maze(bool *grid, int size)
+{
+    const int cells = (size - 1) / 2;
+    Loc *stack = (Loc*) malloc(cells * cells * sizeof(Loc));
+    bool *seen = (bool*) calloc(cells * cells, sizeof(bool));
+    int top = 0;
+    
+    stack[top++] = (Loc){0, 0};
+    seen[0] = true;
+    grid_get_at(grid, size, ((Loc){1, 1})) = true;
+    
+    const Loc steps[4] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+    while(top > 0)
+    {
+        Loc cell = stack[top - 1];
+        
+        // the unseen neighbours of the cell, one is picked at random
+        Loc options[4];
+        int nb_options = 0;
+        for(int i = 0 ; i < 4 ; i++)
+        {
+            Loc next = {cell.x + steps[i].x, cell.y + steps[i].y};
+            if(in_range(next, cells, cells) && !seen[next.y * cells + next.x])
+                options[nb_options++] = next;
+        }
+        
+        if(nb_options == 0)
+        {
+            top--;
+            continue;
+        }
+        
+        Loc next = options[next_random() % nb_options];
+        seen[next.y * cells + next.x] = true;
+        stack[top++] = next;
+        
+        // opens the cell and the wall between it and the previous one
+        grid_get_at(grid, size, ((Loc){2 * next.x + 1, 2 * next.y + 1})) = true;
+        grid_get_at(grid, size, ((Loc){cell.x + next.x + 1, cell.y + next.y + 1})) = true;
+    }
+    
+    free(seen);
+    free(stack);
+}
+
+// splits the map in square rooms with walls between them, and a door in each wall
+static void build_rooms(bool *grid, int size)
+{
+    const int room = 16;
+    
+    for(int y = 0 ; y < size ; y++)
+        for(int x = 0 ; x < size ; x++)
+            grid_get_at(grid, size, ((Loc){x, y})) = x % room != 0 && y % room != 0;
+    
+    // a door two cells wide on the right and bottom walls of every room
+    for(int y = 0 ; y < size ; y += room)
+    {
+        for(int x = 0 ; x < size ; x += room)
+        {
+            const int right = x + room;
+            const int down  = y + room;
+            const int door_y = y + 1 + next_random() % (room - 2);
+            const int door_x = x + 1 + next_random() % (room - 2);
+            
+            for(int i = 0 ; i < 2 ; i++)
+            {
+                if(right < size && door_y + i < size && (door_y + i) % room != 0)
+                    grid_get_at(grid, size, ((Loc){right, door_y + i})) = true;
+                if(down < size && door_x + i < size && (door_x + i) % room != 0)
+                    grid_get_at(grid, size, ((Loc){door_x + i, down})) = true;
+            }
+        }
+    }
+}
+
+// builds a square map of the given kind, the same one for the same seed
+static bool *build_map(Map_Kind kind, int size, uint64_t map_seed)
+{
+    seed(map_seed);
+    bool *grid = (bool*) calloc(grid_size(size, size), sizeof(bool));
+    
+    switch(kind)
+    {
+        case MAP_OPEN:
+        case MAP_RANDOM_10:
+        case MAP_RANDOM_20:
+        case MAP_RANDOM_30:
+        {
+            const uint32_t blocked_percent = kind == MAP_OPEN ? 0 : 10 * (kind - MAP_OPEN);
+            for(int y = 0 ; y < size ; y++)
+                for(int x = 0 ; x < size ; x++)
+                    grid_get_at(grid, size, ((Loc){x, y})) = next_random() % 100 >= blocked_percent;
+            break;
+        }
+        case MAP_MAZE:
+            carve_maze(grid, size);
+            break;
+        case MAP_ROOMS:
+            build_rooms(grid, size);
+            break;
+    }
+    
+    return grid;
+}
+
+// picks a passable cell at random
+static Loc random_passable(const bool *grid, int size)
+{
+    while(1)
+    {
+        Loc loc = {next_random() % size, next_random() % size};
+        if(grid_get_at(grid, size, loc))
+            return loc;
+    }
+}
+
+// the measures of a query set
+typedef struct Run {
+    double ns;
+    long long expanded;
+    long long allocs;
+    int found;
+} Run;
+
+// runs every query with shortest_path, the way the CLI does for a single grid
+static Run run_cold(bool *grid, int size, const Loc *queries, int nb_queries)
+{
+    Run run = {0};
+    const long long allocs = nb_allocs;
+    const double begin = now_ns();
+    
+    for(int i = 0 ; i < nb_queries ; i++)
+    {
+        Path *path = shortest_path(grid, size, size, queries[2 * i], queries[2 * i + 1]);
+        run.found += path != NULL;
+        free(path);
+    }
+    
+    run.ns = now_ns() - begin;
+    run.allocs = nb_allocs - allocs;
+    return run;
+}
+
+// runs every query with a single reused search, the way the batch mode and the server do
+static Run run_warm(bool *grid, int size, const Loc *queries, int nb_queries)
+{
+    Run run = {0};
+    Search search = {0};
+    
+    // the first search allocates the memory the others reuse, it isn't measured
+    find_path(&search, grid, size, size, queries[0], queries[1]);
+    
+    const long long allocs = nb_allocs;
+    const double begin = now_ns();
+    
+    for(int i = 0 ; i < nb_queries ; i++)
+    {
+        run.found += find_path(&search, grid, size, size, queries[2 * i], queries[2 * i + 1]);
+        run.expanded += search.stats.expanded;
+    }
+    
+    run.ns = now_ns() - begin;
+    run.allocs = nb_allocs - allocs;
+    free_search(&search);
+    return run;
+}
+
+// the peak resident memory of the process so far, in megabytes
+static double peak_rss_mb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// pushes and pops nodes with random costs, to time the priority queue on its own
+static void bench_queue(int nb)
+{
+    seed(42);
+    Node *nodes = (Node*) malloc(nb * sizeof(Node));
+    for(int i = 0 ; i < nb ; i++)
+        nodes[i] = (Node){.cost = next_random() / 65536.0f};
+    
+    Priority_Queue q = {0};
+    init_queue(&q, nb);
+    
+    const double begin = now_ns();
+    for(int i = 0 ; i < nb ; i++)
+        enqueue(&q, &nodes[i]);
+    const double pushed = now_ns();
+    
+    float last = -1;
+    bool ordered = true;
+    for(int i = 0 ; i < nb ; i++)
+    {
+        Node *node = dequeue(&q);
+        ordered = ordered && node->cost >= last;
+        last = node->cost;
+    }
+    const double popped = now_ns();
+    
+    printf("queue: %d nodes, %.1f ns/push, %.1f ns/pop%s\n", nb, (pushed - begin) / nb, (popped - pushed) / nb, ordered ? "" : " (OUT OF ORDER)");
+    
+    free(q.data);
+    free(nodes);
+}
+
+// runs many searches at once through a scheduler with a fixed budget per tick, the way a game loop would
+static void bench_scheduler(int nb_searches, int size, long long tick_ns)
+{
+    bool *grid = build_map(MAP_RANDOM_20, size, 99);
+    seed(100);
+    
+    Search *searches = (Search*) calloc(nb_searches, sizeof(Search));
+    int *done_at = (int*) calloc(nb_searches, sizeof(int));
+    Scheduler scheduler = {0};
+    for(int i = 0 ; i < nb_searches ; i++)
+    {
+        Loc start = random_passable(grid, size);
+        Loc end = random_passable(grid, size);
+        search_begin(&searches[i], grid, size, size, start, end);
+        scheduler_add(&scheduler, &searches[i]);
+    }
+    
+    // tick until all the searches are done, noting the tick each one got done on
+    int ticks = 0;
+    double longest_tick = 0;
+    const double begin = now_ns();
+    while(scheduler.nb > 0)
+    {
+        const double tick_begin = now_ns();
+        scheduler_tick(&scheduler, tick_ns);
+        const double tick = now_ns() - tick_begin;
+        longest_tick = tick > longest_tick ? tick : longest_tick;
+        ticks++;
+        
+        for(int i = 0 ; i < nb_searches ; i++)
+            if(done_at[i] == 0 && searches[i].status != SEARCH_IN_PROGRESS)
+                done_at[i] = ticks;
+    }
+    const double total = now_ns() - begin;
+    
+    int first_done = ticks;
+    int found = 0;
+    for(int i = 0 ; i < nb_searches ; i++)
+    {
+        first_done = done_at[i] < first_done ? done_at[i] : first_done;
+        found += searches[i].found;
+        free_search(&searches[i]);
+    }
+    
+    printf("scheduler: %d searches on %d*%d, %.1f ms ticks: %d ticks, %d found, first done on tick %d, tick mean %.3f ms, max %.3f ms\n",
+           nb_searches, size, size, tick_ns / 1e6, ticks, found, first_done, total / ticks / 1e6, longest_tick / 1e6);
+    
+    free_scheduler(&scheduler);
+    free(done_at);
+    free(searches);
+    free(grid);
+}
+
+int main(int argc, char **argv)
+{
+    // --quick only runs the smallest size, for a fast check
+    const bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    
+    // bigger maps get fewer queries, so every size takes about as long
+    const int sizes[]      = {128, 512, 1024};
+    const int nb_queries[] = {400, 40, 10};
+    const int nb_sizes = quick ? 1 : 3;
+    
+    printf("%-9s %5s %7s %9s %9s %11s %9s %9s %8s\n",
+           "map", "size", "queries", "found", "cold q/s", "warm q/s", "ns/node", "allocs/q", "rss MB");
+    
+    for(int s = 0 ; s < nb_sizes ; s++)
+    {
+        const int size = sizes[s];
+        const int n = nb_queries[s];
+        
+        for(Map_Kind kind = MAP_OPEN ; kind <= MAP_ROOMS ; kind++)
+        {
+            bool *grid = build_map(kind, size, 1000 * size + kind);
+            
+            // the queries come from their own seed, so they don't change if a map generator does
+            seed(7 * size + kind);
+            Loc *queries = (Loc*) malloc(2 * n * sizeof(Loc));
+            for(int i = 0 ; i < 2 * n ; i++)
+                queries[i] = random_passable(grid, size);
+            
+            Run cold = run_cold(grid, size, queries, n);
+            Run warm = run_warm(grid, size, queries, n);
+            
+            printf("%-9s %5d %7d %9d %9.1f %11.1f %9.2f %9.1f %8.1f\n",
+                   map_names[kind], size, n, warm.found,
+                   n / (cold.ns / 1e9), n / (warm.ns / 1e9),
+                   warm.expanded ? warm.ns / warm.expanded : 0,
+                   (double) cold.allocs / n, peak_rss_mb());
+            
+            free(queries);
+            free(grid);
+        }
+    }
+    
+    bench_queue(quick ? 1 << 16 : 1 << 20);
+    bench_scheduler(quick ? 16 : 64, quick ? 128 : 256, 1000000);
+    
+    printf("allocator: %lld allocations, %lld frees\n", nb_allocs, nb_frees);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef ANY_ANGLE_H
+#define ANY_ANGLE_H
+
+#include <stdbool.h>
+#include "path_finder.h"
+
+// Represents a path as straight legs between waypoints, from start to end
+typedef struct Waypoints {
+    float cost; // the euclidean length of all the legs
+    int nb;
+    Loc locs[];
+} Waypoints;
+
+// Returns true if the straight line between the centers of a and b only crosses passable cells
+bool line_of_sight(const bool *grid, int cols, Loc a, Loc b);
+
+// Shortens a path by string pulling: every waypoint that has line of sight past the next one is dropped
+// Returns NULL if path is NULL
+Waypoints *smooth_path(const Path *path, Loc start, const bool *grid, int cols);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include "path_finder.h"
+#include "grid_file.h"
+#include "result.h"
+
+// Reads a map from a text file, where each line is a row of '1' for passable and '0' for unpassable
+// a single 'S' and 'E' are read as passable, the start/end points of a map come from the queries
+// Returns NULL and prints the reason to stderr if the file can't be read
+bool *read_text_map(const char *path, int *cols, int *rows);
+
+// A map loaded for many queries, from a binary grid file or a text map
+typedef struct Map {
+    int cols;
+    int rows;
+    bool *grid;
+    Grid_File file; // the mapping, if the map is a binary grid file
+    bool mapped;
+} Map;
+
+// Loads a map, a binary grid file is mapped and a text map is parsed
+// Returns false and prints the reason to stderr if the map can't be loaded
+bool load_map(const char *path, Map *map);
+
+// Frees a map loaded by load_map
+void free_map(Map *map);
+
+// Loads the map once and answers every query in the queries file, one line per query on stdout
+// the map is a binary grid file or a text map, and each query line is "start_x start_y end_x end_y"
+// each result is written in the given format, with the path only if 'encode' is set
+// if 'print_search_stats' is set, the stats of all the searches are printed to stderr at the end
+// Returns the exit code of the program
+int run_batch(const char *map_path, const char *queries_path, bool encode, Output_Format format, bool print_search_stats);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef GRID_FILE_H
+#define GRID_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "path_finder.h"
+
+// A binary grid file is a header followed by the obstacles grid, one byte per cell (1 passable, 0 unpassable)
+// The payload is laid out exactly like the grid in memory, so it can be mapped and searched without parsing
+#define GRID_FILE_MAGIC   "PFGRID\r\n"
+#define GRID_FILE_VERSION 1
+
+// the payload starts at this offset, so it is page aligned when mapped
+#define GRID_FILE_PAYLOAD_OFFSET 4096
+
+// set in the header's flags if the payload is stored in the tiled layout (see PATH_FINDER_TILED)
+#define GRID_FILE_TILED 1
+
+// The header at the start of a binary grid file, all fields are in the byte order of the machine that wrote it
+typedef struct Grid_File_Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int32_t cols;
+    int32_t rows;
+    int32_t start_x; // -1 if the start point isn't set
+    int32_t start_y;
+    int32_t end_x;   // -1 if the end point isn't set
+    int32_t end_y;
+    uint64_t payload_offset;
+    uint64_t payload_size;
+} Grid_File_Header;
+
+// A grid file mapped in memory
+typedef struct Grid_File {
+    int cols;
+    int rows;
+    Loc start;
+    Loc end;
+    bool *grid; // points into the mapping, changes to it are private to the process
+    void *mapping;
+    size_t mapping_size;
+} Grid_File;
+
+// Maps a binary grid file in memory, the payload is only scanned once for bytes other than 0 and 1, which are read as passable
+// the pages of the payload are then left to the system, so a grid bigger than the memory can still be searched out of core
+// Returns false and prints the reason to stderr if the file can't be mapped
+bool map_grid_file(const char *path, Grid_File *file);
+
+// Unmaps a grid file mapped by map_grid_file
+void unmap_grid_file(Grid_File *file);
+
+// Writes the grid and the start/end points to a binary grid file
+// Returns false and prints the reason to stderr if the file can't be written
+bool save_grid_file(const char *path, const bool *grid, int cols, int rows, Loc start, Loc end);
+
+#endif
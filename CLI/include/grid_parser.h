@@ -0,0 +1,34 @@
+#ifndef GRID_PARSER_H
+#define GRID_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "path_finder.h"
+
+// The whole contents of a file or of stdin, mapped if it's a regular file and read otherwise
+typedef struct Input {
+    const char *data;
+    size_t len;
+    bool mapped;
+} Input;
+
+// Reads everything from a file descriptor in one go
+// Returns false and prints the reason to stderr if it can't be read
+bool read_input(int fd, Input *input);
+
+// Frees the contents read by read_input
+void free_input(Input *input);
+
+// Parses a grid of 'rows' lines of 'cols' characters, '1' for passable and '0' for unpassable
+// every line ends with '\n' or "\r\n", except the last one which may end the input
+// 'start' and 'end' are set to the 'S'/'s' and 'E'/'e' cells, or to {-1, -1} if there is none
+// 'line_end' is set to right after the last line
+// Returns NULL and prints the reason to stderr if the grid is invalid
+bool *parse_grid(const char *data, size_t len, int cols, int rows, Loc *start, Loc *end, const char **line_end);
+
+// Parses a whole input made of the number of rows, the number of cols and then the rows,
+// the same things the program asks for when run interactively
+// Returns NULL and prints the reason to stderr if the input is invalid or misses the start/end point
+bool *parse_grid_input(const Input *input, int *cols, int *rows, Loc *start, Loc *end);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef MOVINGAI_H
+#define MOVINGAI_H
+
+#include <stdbool.h>
+
+// Reads a MovingAI benchmark map (.map) into an obstacles grid
+// '.', 'G' and 'S' are passable, every other terrain ('@', 'O', 'T', 'W') is unpassable
+// Returns NULL and prints the reason to stderr if the file can't be read
+bool *read_movingai_map(const char *path, int *cols, int *rows);
+
+// Runs every scenario of a MovingAI scenario file (.scen) and checks each cost against the optimal length
+// the map of each scenario is looked up next to the scenario file, unless 'map_path' is given
+// prints every mismatch, then the search stats and the time per query with percentiles
+// Returns the exit code of the program, 1 if any scenario failed
+int run_scenarios(const char *scen_path, const char *map_path);
+
+#endif
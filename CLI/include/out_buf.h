@@ -0,0 +1,26 @@
+#ifndef OUT_BUF_H
+#define OUT_BUF_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// the number of bytes an Out_Buf holds before it's written out
+#define OUT_BUF_SIZE (1 << 16)
+
+// A fixed size output buffer, written to its file in big chunks
+typedef struct Out_Buf {
+    FILE *f;
+    size_t len;
+    char data[OUT_BUF_SIZE];
+} Out_Buf;
+
+// Appends bytes to the buffer, writing it out whenever it's full
+void out_write(Out_Buf *out, const void *data, size_t len);
+
+// Appends a nul terminated string to the buffer
+void out_puts(Out_Buf *out, const char *str);
+
+// Writes out everything in the buffer
+void out_flush(Out_Buf *out);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <stddef.h>
+#include "path_finder.h"
+
+// Configures a search whose node grid doesn't fit in memory
+typedef struct Out_Of_Core_Options {
+    size_t max_resident_bytes; // how much memory the node tiles kept in memory may take
+    int tile_size;             // the width and height of a tile in cells, 0 for the default of 64
+    const char *scratch_path;  // the file the tiles are paged to, NULL for an anonymous temporary file
+} Out_Of_Core_Options;
+
+// Sets 'path' to the shortest path from start to end, or to NULL if there is none, like shortest_path, while keeping at most
+// 'max_resident_bytes' of the node grid in memory. The node grid is split in square tiles
+// that are paged to a scratch file when they are not used, trading speed for a fixed memory ceiling.
+// The obstacles grid is only read, so it can be a mapped grid file that the system pages in as needed.
+// At least nine tiles are kept in memory (a tile and its neighbours), even if they take more than 'max_resident_bytes'.
+// The frontier of the search counts against 'max_resident_bytes' too: tiles are given back as it grows,
+// and the search fails if it doesn't fit next to the nine tiles.
+// Returns false, with an error printed, if the scratch file can't be opened, read or written or if the frontier outgrows the ceiling,
+// since the search can't finish then
+bool shortest_path_out_of_core(const bool *grid, int cols, int rows, Loc start, Loc end, Out_Of_Core_Options options, Path **path);
+
+#endif
@@ -2,10 +2,44 @@
 #define PATH_FINDER
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "priority_queue.h"
+
+#ifdef PATH_FINDER_TILED
+
+// grids are stored as 8x8 tiles, with the cells of a tile next to each other and the tiles stored row by row
+// this keeps the vertical and diagonal neighbours of a cell close in memory on wide grids
+#define TILE_SHIFT 3
+#define TILE_SIZE  (1 << TILE_SHIFT)
+#define TILE_MASK  (TILE_SIZE - 1)
+
+// rounds a number of rows/cols up to a whole number of tiles
+#define tiles_round_up(n) \
+(((n) + TILE_MASK) & ~TILE_MASK)
+
+// the number of cells to allocate for a grid
+#define grid_size(cols, rows) \
+((size_t) tiles_round_up(cols) * tiles_round_up(rows))
+
+// the index of a 2D point in a 1D array
+#define grid_index(cols, loc) \
+(((((size_t) (loc).y >> TILE_SHIFT) * tiles_round_up(cols) + ((loc).x & ~TILE_MASK)) << TILE_SHIFT) + (((loc).y & TILE_MASK) << TILE_SHIFT) + ((loc).x & TILE_MASK))
+
+#else
+
+// the number of cells to allocate for a grid
+#define grid_size(cols, rows) \
+((size_t) (cols) * (rows))
+
+// the index of a 2D point in a 1D array
+#define grid_index(cols, loc) \
+((size_t) (loc).y * (cols) + (loc).x)
+
+#endif
 
 // a convenience macro for accessing a 2D point in a 1D array
 #define grid_get_at(grid, cols, loc) \
-grid[ loc.y * cols + loc.x ]
+grid[ grid_index(cols, loc) ]
 
 // Describes a point on a grid
 typedef struct Loc
@@ -43,9 +77,138 @@ typedef struct Node {
     int nb_steps;
 } Node;
 
+// Counts the work done by a search
+// the expansions and pushes are always counted, an increment each, the rest is only filled when built with PATH_FINDER_STATS
+// the times of the phases are measured when also built with PATH_FINDER_STATS_TIME, which reads the clock a few times per search
+// the times of every pop, push and expansion are only measured when built with PATH_FINDER_STATS_OP_TIME, which slows the search down a lot
+typedef struct Search_Stats {
+    long long expanded;      // nodes taken out of the queue and expanded, always counted
+    long long pushes;        // nodes put in the queue, always counted
+    long long pops;          // nodes taken out of the queue, including the stale entries that are skipped
+    long long decrease_keys; // pushes of a node already in the queue at a higher cost, its old entry goes stale
+    long long max_queue_size;
+    long long reset_ns;      // time spent resetting the node grid and the queue before the search
+    long long search_ns;     // time spent expanding nodes, from the first expansion to the last
+    long long path_ns;       // time spent walking the path into a Path, only by shortest_path_with_stats
+    long long pop_ns;        // time spent taking nodes out of the queue, only with PATH_FINDER_STATS_OP_TIME
+    long long push_ns;       // time spent putting nodes in the queue, only with PATH_FINDER_STATS_OP_TIME
+    long long expand_ns;     // time spent checking the neighbours of expanded nodes without the pushes, only with PATH_FINDER_STATS_OP_TIME
+} Search_Stats;
+
+#ifdef PATH_FINDER_STATS_OP_TIME
+#ifndef PATH_FINDER_STATS_TIME
+#define PATH_FINDER_STATS_TIME
+#endif
+#endif
+
+#ifdef PATH_FINDER_STATS_TIME
+#ifndef PATH_FINDER_STATS
+#define PATH_FINDER_STATS
+#endif
+
+// Returns a monotonic time in nanoseconds
+long long stats_now_ns();
+
+// runs a statement and adds the time it took to a field of the stats
+#define stats_time(stats, field, statement) \
+do { const long long stats_begin_ = stats_now_ns(); statement; (stats)->field += stats_now_ns() - stats_begin_; } while(0)
+#else
+#define stats_time(stats, field, statement) \
+do { statement; } while(0)
+#endif
+
+// same as stats_time, for the operations done for every node, which are only timed with PATH_FINDER_STATS_OP_TIME
+#ifdef PATH_FINDER_STATS_OP_TIME
+#define stats_op_time(stats, field, statement) \
+stats_time(stats, field, statement)
+#else
+#define stats_op_time(stats, field, statement) \
+do { statement; } while(0)
+#endif
+
+#ifdef PATH_FINDER_STATS
+#define stats_add(stats, field, n) \
+((stats)->field += (n))
+#define stats_max(stats, field, n) \
+((stats)->field = (stats)->field > (n) ? (stats)->field : (n))
+#else
+#define stats_add(stats, field, n) \
+((void) 0)
+#define stats_max(stats, field, n) \
+((void) 0)
+#endif
+
+// Where a search run in steps is at, see search_step
+typedef enum Search_Status {
+    SEARCH_IN_PROGRESS = 0, // the search needs more steps
+    SEARCH_FOUND       = 1,
+    SEARCH_NOT_FOUND   = 2
+} Search_Status;
+
+// Holds the result of a search. The node grid is retained so the path can be walked lazily,
+// and the node grid and queue are reused by the next search on the same struct
+typedef struct Search {
+    Search_Status status;
+    bool found;
+    float cost;
+    int nb; // number of steps from start to end
+    int cols;
+    int rows;
+    Loc start;
+    Loc end;
+    bool *obstacle_grid; // the grid of the search in progress, it must not change until the search is done
+    size_t cap; // number of nodes allocated in node_grid
+    Node *node_grid;
+    Priority_Queue unexpanded;
+    Search_Stats stats;
+    bool no_corner_cutting; // when set, a diagonal step needs both cells beside it to be passable
+} Search;
+
+// Walks the path of a finished search one step at a time, from start to end
+typedef struct Path_Iter {
+    const Node *node_grid;
+    int cols;
+    Loc current;
+    Loc end;
+} Path_Iter;
+
 // Returns the shortest path from start to end, avoiding obstacles on the grid
 Path* shortest_path(bool *grid, int cols, int rows, Loc start, Loc end);
 
+// Same as shortest_path, and fills 'stats' with the work the search did if it's not NULL
+Path* shortest_path_with_stats(bool *grid, int cols, int rows, Loc start, Loc end, Search_Stats *stats);
+
+// Adds the stats of a search to a total, keeping the biggest queue size
+void stats_merge(Search_Stats *total, const Search_Stats *stats);
+
+// Searches for the shortest path from start to end without building the path
+// 'search' must be zero initialized before its first use, and can be reused for later searches
+// Returns true if a path was found
+bool find_path(Search *search, bool *grid, int cols, int rows, Loc start, Loc end);
+
+// Starts a search from start to end that runs in steps with search_step, instead of all at once like find_path
+// 'search' must be zero initialized before its first use, and can be reused for later searches
+void search_begin(Search *search, bool *grid, int cols, int rows, Loc start, Loc end);
+
+// Runs a started search until it's done, it expanded 'max_expansions' more nodes,
+// or the monotonic clock (see search_now_ns) passed 'deadline_ns'. A limit of 0 means no limit
+// the clock is read every few expansions, so the search can overrun the deadline by a little
+// Returns where the search is at, once done the search holds its result the way find_path leaves it
+Search_Status search_step(Search *search, long long max_expansions, long long deadline_ns);
+
+// Returns the monotonic clock in nanoseconds, the clock of the deadlines of search_step
+long long search_now_ns();
+
+// Frees the memory retained by a search
+void free_search(Search *search);
+
+// Returns an iterator over the path of a search, starting at the start point
+Path_Iter path_iter(const Search *search);
+
+// Writes the next direction of the path to 'dir' and the location it leads to into the iterator
+// Returns false once the end was reached
+bool path_iter_next(Path_Iter *iter, Parent_Direction *dir);
+
 // Applies a direction to a given location
 // Retruns the resulting location
 Loc next_loc(Loc loc, Parent_Direction direction);
@@ -56,4 +219,7 @@ bool in_range(Loc loc, int cols, int rows);
 // Returns true if l1 is the same location as l2
 bool locs_eq(Loc l1, Loc l2);
 
+// Returns the location of an index in a grid, the inverse of grid_index
+Loc grid_loc(size_t index, int cols);
+
 #endif
@@ -1,16 +1,21 @@
 #ifndef PRIORITY_QUEUE_H
 #define PRIORITY_QUEUE_H
 
-#include "path_finder.h"
+#include <stddef.h>
+
+typedef struct Node Node;
 
 // A priority queue of Node pointers
 typedef struct Priority_Queue {
-    int size;
+    size_t size;
+    size_t cap;
     Node **data;
 } Priority_Queue;
 
-// initialize the Priority_Queue with 'cap' as the maximum capacity.
-Priority_Queue init_queue(int cap);
+// initialize the Priority_Queue with 'cap' as the initial capacity.
+// reuses the memory of the queue if it's already big enough
+// exits the program if the memory can't be allocated, like the other allocations of a search
+void init_queue(Priority_Queue *q, size_t cap);
 
 // Adds the element to the Priority_Queue
 void enqueue(Priority_Queue *q, Node *node);
@@ -0,0 +1,29 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include "path_finder.h"
+
+// A rectangle of cells to print, from 'min' to 'max' inclusive
+typedef struct Window {
+    Loc min;
+    Loc max;
+} Window;
+
+// Prints the cost of the path, then the obstacles grid with the path from start to end drawn as arrows
+// the grid is written row by row through a fixed size buffer, so memory use doesn't grow with the grid
+void print_path(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows);
+
+// Same as print_path, but only prints the cells within the window
+void print_path_window(Path *path, Loc start, Loc end, const bool *obstacles, int cols, Window window);
+
+// Returns the smallest window holding the whole path, grown by 'margin' cells on every side but kept within the grid
+Window path_window(Path *path, Loc start, int margin, int cols, int rows);
+
+// Prints the cost of the path, then an overview of the grid at most 'width' characters wide
+// each character summarizes a square block of cells: 'S'/'E' for the blocks of the start/end point,
+// '*' for the blocks the path goes through, and a shade for how many of the cells are unpassable otherwise
+// only a few cells of each block are sampled, so the time taken depends on the width and not on the grid size
+void print_overview(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows, int width);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef RESULT_H
+#define RESULT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "path_finder.h"
+#include "out_buf.h"
+
+// How the result of a query is written
+typedef enum Output_Format {
+    FORMAT_TEXT,   // "cost steps [path]" on one line, or "-1 0" if there is no path
+    FORMAT_JSON,   // one JSON object per line: {"cost":7.83,"steps":7,"path":"7788888"}, the cost is null if there is no path
+    FORMAT_BINARY  // a Result_Record followed by its packed directions
+} Output_Format;
+
+// The fixed size part of a binary result, in the byte order of the machine that wrote it
+// it's followed by 'packed_len' bytes holding two directions each, the first one in the low 4 bits
+// (values as in Parent_Direction, 0 pads the last byte) or by nothing if the path wasn't asked for
+typedef struct Result_Record {
+    double cost;        // -1 if there is no path
+    uint32_t steps;
+    uint32_t packed_len;
+} Result_Record;
+
+// Returns the character a direction is written as in a text or JSON path
+// the digits follow a numeric keypad: '8' is up, '6' is right, '9' is up right and so on
+char dir_to_char(Parent_Direction dir);
+
+// Parses an output format name ("text", "json" or "binary")
+// Returns false if the name isn't one of them
+bool parse_output_format(const char *name, Output_Format *format);
+
+// Writes the result of a query in the given format
+// 'dirs' holds the 'nb' directions of the path, or is NULL to leave the path out
+void write_result(Out_Buf *out, Output_Format format, bool found, float cost, int nb, const Parent_Direction *dirs);
+
+// Prints the stats of 'nb_searches' searches, summed by stats_merge, with the averages per search
+// the expansions and pushes are always printed, for the rest it prints how to get them if the program isn't built to count them
+void print_stats(FILE *f, const Search_Stats *stats, long long nb_searches);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "path_finder.h"
+
+// Shares a time budget between many searches run in steps, for a game loop that gives pathfinding a few milliseconds per tick
+// each search of a tick gets an equal share of the time left, so the time a finished search didn't use goes to the others,
+// and the search that runs first changes every tick, so none is always left with what the others overran
+typedef struct Scheduler {
+    Search **searches; // the searches in progress, in the order they run
+    int nb;
+    int cap;
+    int first; // the index of the search that runs first on the next tick
+} Scheduler;
+
+// Adds a search started with search_begin, it runs on the next ticks until it's done
+// the search is left in place once done, with its result in it
+void scheduler_add(Scheduler *scheduler, Search *search);
+
+// Removes a search before it's done, for an agent that doesn't need its path anymore
+void scheduler_remove(Scheduler *scheduler, Search *search);
+
+// Runs the searches for about 'budget_ns' nanoseconds of the monotonic clock, removing the ones that get done
+// Returns the number of searches still in progress
+int scheduler_tick(Scheduler *scheduler, long long budget_ns);
+
+// Frees the memory of the scheduler, not the searches
+void free_scheduler(Scheduler *scheduler);
+
+#endif
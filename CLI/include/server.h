@@ -0,0 +1,83 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The query server answers requests sent over a Unix domain socket
+// Every message starts with a Request_Header and every answer with a Response_Header
+// all fields are in the byte order of the machine, since both ends run on it
+// A connection can send many requests without waiting for their answers,
+// answers carry the id of their request and may come in a different order
+
+// the types of request messages
+typedef enum Message_Type {
+    MESSAGE_QUERY = 1, // followed by a Query_Request
+    MESSAGE_DELTA = 2  // followed by a Delta_Request and its Cell_Updates
+} Message_Type;
+
+// set in a query's flags to get the directions of the path in the answer
+#define QUERY_ENCODE 1
+
+typedef struct Request_Header {
+    uint32_t type;
+    uint32_t id; // chosen by the client, sent back in the answer
+} Request_Header;
+
+typedef struct Query_Request {
+    int32_t start_x;
+    int32_t start_y;
+    int32_t end_x;
+    int32_t end_y;
+    uint32_t flags;
+} Query_Request;
+
+// Changes the passability of some cells, all at once for the queries that follow
+// a query sent once the answer of a delta is received sees the delta,
+// but a query already searching when the delta is applied finishes on the grid it started with, even if it's answered after the delta
+typedef struct Delta_Request {
+    uint32_t nb; // the number of Cell_Updates that follow
+} Delta_Request;
+
+typedef struct Cell_Update {
+    int32_t x;
+    int32_t y;
+    uint32_t passable; // 0 for unpassable, anything else for passable
+} Cell_Update;
+
+// the most cells a single delta can change
+#define DELTA_MAX_CELLS (1 << 20)
+
+// the status of an answer
+typedef enum Response_Status {
+    STATUS_OK          = 0, // followed by a binary result (see Result_Record in result.h) for a query,
+                            // or by the uint64_t version of the grid it made for a delta
+    STATUS_BAD_REQUEST = 1  // a point or cell is outside the map, nothing follows and nothing was changed
+} Response_Status;
+
+typedef struct Response_Header {
+    uint32_t id;
+    uint32_t status;
+} Response_Header;
+
+// Loads the map once and answers queries on a Unix domain socket at 'socket_path' until killed
+// each of the 'nb_threads' workers keeps its own search, so no memory is allocated per query once warm
+// deltas are applied to a copy of the grid that replaces it once complete, so queries never wait for them
+// Returns the exit code of the program
+int run_server(const char *map_path, const char *socket_path, int nb_threads);
+
+// How the load generator drives a server
+typedef struct Client_Options {
+    int connections;    // connections opened at once, each on its own thread
+    int pipeline;       // requests sent on a connection without waiting for their answers
+    long long requests; // requests sent in total, the queries are sent again and again until then
+    bool encode;        // ask for the directions of the paths
+    int delta_every;    // if not 0, every one in 'delta_every' requests is a delta flipping a cell of the queries
+} Client_Options;
+
+// Sends the queries of the queries file (same format as the batch mode) to a running server
+// and prints the throughput and the latency percentiles of the answers
+// Returns the exit code of the program
+int run_client(const char *socket_path, const char *queries_path, Client_Options options);
+
+#endif
@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <math.h>
+#include "../include/any_angle.h"
+
+bool line_of_sight(const bool *grid, int cols, Loc a, Loc b)
+{
+    const int nx = abs(b.x - a.x);
+    const int ny = abs(b.y - a.y);
+    const int step_x = b.x > a.x ? 1 : -1;
+    const int step_y = b.y > a.y ? 1 : -1;
+    
+    // walk every cell the line crosses (a supercover traversal)
+    // 'ix' and 'iy' count the vertical and horizontal cell borders crossed so far
+    Loc current = a;
+    int ix = 0;
+    int iy = 0;
+    while(ix < nx || iy < ny)
+    {
+        // compares where the line crosses the next vertical border against the next horizontal border
+        // multiplied out so it stays in integers: (0.5 + ix) / nx vs (0.5 + iy) / ny
+        long long next_border = (long long)(1 + 2 * ix) * ny - (long long)(1 + 2 * iy) * nx;
+        
+        if(next_border == 0)
+        {
+            // the line goes exactly through a corner, step diagonally like the search does
+            current.x += step_x;
+            current.y += step_y;
+            ix++;
+            iy++;
+        }
+        else if(next_border < 0)
+        {
+            current.x += step_x;
+            ix++;
+        }
+        else
+        {
+            current.y += step_y;
+            iy++;
+        }
+        
+        if(!grid_get_at(grid, cols, current))
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Returns the euclidean distance between the centers of two cells
+static float distance(Loc a, Loc b)
+{
+    return sqrtf((float)(a.x - b.x) * (a.x - b.x) + (float)(a.y - b.y) * (a.y - b.y));
+}
+
+Waypoints *smooth_path(const Path *path, Loc start, const bool *grid, int cols)
+{
+    if(path == NULL)
+    {
+        return NULL;
+    }
+    
+    // at most every cell of the path is a waypoint
+    Waypoints *waypoints = (Waypoints*) malloc(sizeof(Waypoints) + sizeof(Loc) * (path->nb + 1));
+    waypoints->nb = 0;
+    waypoints->cost = 0;
+    waypoints->locs[waypoints->nb++] = start;
+    
+    // 'anchor' is the last waypoint, 'previous' is the last cell of the path that it can see
+    Loc anchor   = start;
+    Loc previous = start;
+    for(int i = 0 ; i < path->nb ; i++)
+    {
+        Loc current = next_loc(previous, path->dirs[i]);
+        
+        // the anchor can't see the current cell, so the leg has to end at the previous cell
+        // a step of the path itself is always kept, even if it goes between two diagonal obstacles
+        if(!locs_eq(anchor, previous) && !line_of_sight(grid, cols, anchor, current))
+        {
+            waypoints->cost += distance(anchor, previous);
+            waypoints->locs[waypoints->nb++] = previous;
+            anchor = previous;
+        }
+        
+        previous = current;
+    }
+    
+    // the last leg ends at the end point
+    if(!locs_eq(anchor, previous))
+    {
+        waypoints->cost += distance(anchor, previous);
+        waypoints->locs[waypoints->nb++] = previous;
+    }
+    
+    return waypoints;
+}
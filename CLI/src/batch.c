@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/batch.h"
+#include "../include/grid_parser.h"
+#include "../include/result.h"
+
+// returns true if the line from 'line' to 'line_end' (its '\n' or the end of the data) is empty or only a '\r'
+static bool is_blank_line(const char *line, const char *line_end)
+{
+    return line_end == line || (line_end == line + 1 && *line == '\r');
+}
+
+// sets 'copy' to a copy of the data without its blank lines and 'len' to its length,
+// or 'copy' to NULL if it has no blank line, which is the usual case, so most maps are parsed without a copy
+// Returns false and prints the reason to stderr if the copy can't be allocated
+static bool drop_blank_lines(const char *data, size_t *len, char **copy)
+{
+    *copy = NULL;
+    
+    const char *end = data + *len;
+    const char *line = data;
+    while(line < end)
+    {
+        const char *newline = (const char*) memchr(line, '\n', end - line);
+        const char *line_end = newline ? newline : end;
+        if(is_blank_line(line, line_end))
+            break;
+        line = newline ? newline + 1 : end;
+    }
+    if(line >= end)
+        return true;
+    
+    if((*copy = (char*) malloc(*len)) == NULL)
+    {
+        fprintf(stderr, "Can't allocate a copy of the %zu bytes of the map\n", *len);
+        return false;
+    }
+    size_t copy_len = 0;
+    for(line = data ; line < end ; )
+    {
+        const char *newline = (const char*) memchr(line, '\n', end - line);
+        const char *next = newline ? newline + 1 : end;
+        if(!is_blank_line(line, newline ? newline : end))
+        {
+            memcpy(*copy + copy_len, line, next - line);
+            copy_len += next - line;
+        }
+        line = next;
+    }
+    
+    *len = copy_len;
+    return true;
+}
+
+bool *read_text_map(const char *path, int *cols, int *rows)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd == -1)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    
+    Input input;
+    bool read = read_input(fd, &input);
+    close(fd);
+    if(!read)
+        return NULL;
+    
+    // blank lines are skipped, wherever they are
+    size_t len = input.len;
+    char *compacted;
+    if(!drop_blank_lines(input.data, &len, &compacted))
+    {
+        free_input(&input);
+        return NULL;
+    }
+    const char *data = compacted ? compacted : input.data;
+    
+    // trailing newlines don't make more rows
+    while(len > 0 && (data[len - 1] == '\n' || data[len - 1] == '\r'))
+        len--;
+    
+    if(len == 0)
+    {
+        fprintf(stderr, "'%s' is empty\n", path);
+        free(compacted);
+        free_input(&input);
+        return NULL;
+    }
+    
+    // the first line gives the number of cols, and every line is a row
+    const char *first_newline = (const char*) memchr(data, '\n', len);
+    *cols = first_newline ? first_newline - data : (ptrdiff_t) len;
+    if(*cols > 0 && data[*cols - 1] == '\r')
+        (*cols)--;
+    
+    *rows = 1;
+    for(const char *p = first_newline ; p != NULL ; p = (const char*) memchr(p + 1, '\n', len - (p + 1 - data)))
+        (*rows)++;
+    
+    Loc start;
+    Loc end;
+    const char *line_end;
+    bool *grid = parse_grid(data, len, *cols, *rows, &start, &end, &line_end);
+    if(grid == NULL)
+        fprintf(stderr, "in '%s'\n", path);
+    
+    free(compacted);
+    free_input(&input);
+    return grid;
+}
+
+// returns true if the file at 'path' starts like a binary grid file
+static bool is_grid_file(const char *path)
+{
+    char magic[8];
+    FILE *f = fopen(path, "rb");
+    if(f == NULL)
+        return false;
+    
+    bool ret = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, GRID_FILE_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return ret;
+}
+
+bool load_map(const char *path, Map *map)
+{
+    *map = (Map){0};
+    map->mapped = is_grid_file(path);
+    if(map->mapped)
+    {
+        if(!map_grid_file(path, &map->file))
+            return false;
+        map->cols = map->file.cols;
+        map->rows = map->file.rows;
+        map->grid = map->file.grid;
+        return true;
+    }
+    
+    map->grid = read_text_map(path, &map->cols, &map->rows);
+    return map->grid != NULL;
+}
+
+void free_map(Map *map)
+{
+    if(map->mapped)
+        unmap_grid_file(&map->file);
+    else
+        free(map->grid);
+}
+
+int run_batch(const char *map_path, const char *queries_path, bool encode, Output_Format format, bool print_search_stats)
+{
+    Map map;
+    if(!load_map(map_path, &map))
+        return 1;
+    
+    const int cols = map.cols;
+    const int rows = map.rows;
+    bool *grid = map.grid;
+    
+    FILE *queries = fopen(queries_path, "r");
+    if(queries == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", queries_path, strerror(errno));
+        free_map(&map);
+        return 1;
+    }
+    
+    // results are written in big chunks instead of one by one
+    static Out_Buf out;
+    out.f = stdout;
+    out.len = 0;
+    
+    // a single search is reused by all the queries, so its memory is only allocated once
+    // and so is the buffer the directions of an encoded path are gathered in
+    Search search = {0};
+    Parent_Direction *dirs = NULL;
+    int dirs_cap = 0;
+    Search_Stats stats = {0};
+    long long nb_searches = 0;
+    int exit_code = 0;
+    int line_nb = 0;
+    
+    char *line = NULL;
+    size_t line_cap = 0;
+    while(getline(&line, &line_cap, queries) != -1)
+    {
+        line_nb++;
+        
+        // skip empty lines and comments
+        char *first = line + strspn(line, " \t");
+        if(*first == '\n' || *first == '\0' || *first == '#')
+            continue;
+        
+        Loc start;
+        Loc end;
+        if(sscanf(line, "%d %d %d %d", &start.x, &start.y, &end.x, &end.y) != 4
+           || !in_range(start, cols, rows) || !in_range(end, cols, rows))
+        {
+            fprintf(stderr, "'%s' line #%d: expected \"start_x start_y end_x end_y\" within the %dx%d map\n", queries_path, line_nb, cols, rows);
+            exit_code = 1;
+            break;
+        }
+        
+        find_path(&search, grid, cols, rows, start, end);
+        stats_merge(&stats, &search.stats);
+        nb_searches++;
+        
+        if(encode && search.found)
+        {
+            // the empty path of a query from a cell to itself still needs a buffer, or it would be left out of the result
+            if(search.nb > dirs_cap || dirs == NULL)
+            {
+                dirs_cap = search.nb * 2 + 1;
+                dirs = (Parent_Direction*) realloc(dirs, dirs_cap * sizeof(Parent_Direction));
+            }
+            
+            Path_Iter iter = path_iter(&search);
+            for(int i = 0 ; path_iter_next(&iter, &dirs[i]) ; i++);
+        }
+        
+        write_result(&out, format, search.found, search.cost, search.nb, encode ? dirs : NULL);
+    }
+    
+    // cleanup
+    out_flush(&out);
+    fflush(stdout);
+    if(print_search_stats)
+        print_stats(stderr, &stats, nb_searches);
+    free(dirs);
+    free(line);
+    free_search(&search);
+    fclose(queries);
+    free_map(&map);
+    
+    return exit_code;
+}
@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../include/server.h"
+#include "../include/result.h"
+
+// The state of one connection of the load generator
+typedef struct Client_Conn {
+    const char *socket_path;
+    const Query_Request *queries;
+    int nb_queries;
+    int first_query;  // each connection starts at a different query, so they don't all send the same ones at once
+    long long requests;
+    int pipeline;
+    bool encode;
+    int delta_every;
+    int max_x;        // deltas change cells within the points of the queries
+    int max_y;
+    
+    double *latencies; // in microseconds, one per request
+    long long not_found;
+    long long bad_requests;
+    long long deltas;
+    bool failed;
+} Client_Conn;
+
+// returns true if the request with this id is a delta
+static bool is_delta(const Client_Conn *c, long long id)
+{
+    return c->delta_every > 0 && id % c->delta_every == c->delta_every - 1;
+}
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// compares two doubles for qsort
+static int compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*) a;
+    const double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// reads the "start_x start_y end_x end_y" lines of a queries file
+// Returns NULL and prints the reason to stderr if the file can't be read or has no queries
+static Query_Request *read_queries(const char *path, int *nb)
+{
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    
+    Query_Request *queries = NULL;
+    int cap = 0;
+    *nb = 0;
+    
+    char *line = NULL;
+    size_t line_cap = 0;
+    int line_nb = 0;
+    while(getline(&line, &line_cap, f) != -1)
+    {
+        line_nb++;
+        
+        // skip empty lines and comments
+        char *first = line + strspn(line, " \t");
+        if(*first == '\n' || *first == '\0' || *first == '#')
+            continue;
+        
+        if(*nb == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            queries = (Query_Request*) realloc(queries, cap * sizeof(Query_Request));
+        }
+        
+        Query_Request *query = &queries[*nb];
+        if(sscanf(line, "%d %d %d %d", &query->start_x, &query->start_y, &query->end_x, &query->end_y) != 4)
+        {
+            fprintf(stderr, "'%s' line #%d: expected \"start_x start_y end_x end_y\"\n", path, line_nb);
+            free(queries);
+            queries = NULL;
+            break;
+        }
+        (*nb)++;
+    }
+    
+    free(line);
+    fclose(f);
+    
+    if(queries != NULL && *nb == 0)
+    {
+        fprintf(stderr, "'%s' has no queries\n", path);
+        free(queries);
+        queries = NULL;
+    }
+    return queries;
+}
+
+// sends the requests of one connection, keeping up to 'pipeline' of them unanswered
+static void *drive_connection(void *arg)
+{
+    Client_Conn *c = (Client_Conn*) arg;
+    
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strncpy(addr.sun_path, c->socket_path, sizeof(addr.sun_path) - 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd == -1 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) == -1)
+    {
+        fprintf(stderr, "Can't connect to '%s': %s\n", c->socket_path, strerror(errno));
+        if(fd != -1)
+            close(fd);
+        c->failed = true;
+        return NULL;
+    }
+    
+    FILE *out = fdopen(dup(fd), "w");
+    FILE *in  = fdopen(fd, "r");
+    
+    // the send time of every request, indexed by its id
+    double *sent_at = (double*) malloc(c->requests * sizeof(double));
+    long long sent = 0;
+    long long received = 0;
+    
+    while(received < c->requests)
+    {
+        // fill the pipeline, then wait for an answer before sending more
+        while(sent < c->requests && sent - received < c->pipeline)
+        {
+            sent_at[sent] = now_us();
+            if(is_delta(c, sent))
+            {
+                // a cell picked from the id, made unpassable and passable again every other time
+                Request_Header header = {.type = MESSAGE_DELTA, .id = (uint32_t) sent};
+                Delta_Request request = {.nb = 1};
+                const long long n = sent / c->delta_every;
+                const uint64_t hash = (uint64_t) (n / 2 + c->first_query) * 0x9E3779B97F4A7C15ull;
+                Cell_Update cell = {
+                    .x = (int32_t) ((hash >> 16) % (c->max_x + 1)),
+                    .y = (int32_t) ((hash >> 40) % (c->max_y + 1)),
+                    .passable = n % 2
+                };
+                
+                fwrite(&header, sizeof(header), 1, out);
+                fwrite(&request, sizeof(request), 1, out);
+                fwrite(&cell, sizeof(cell), 1, out);
+            }
+            else
+            {
+                Request_Header header = {.type = MESSAGE_QUERY, .id = (uint32_t) sent};
+                Query_Request query = c->queries[(c->first_query + sent) % c->nb_queries];
+                query.flags = c->encode ? QUERY_ENCODE : 0;
+                
+                fwrite(&header, sizeof(header), 1, out);
+                fwrite(&query, sizeof(query), 1, out);
+            }
+            sent++;
+        }
+        fflush(out);
+        
+        Response_Header header;
+        if(fread(&header, sizeof(header), 1, in) != 1 || header.id >= sent)
+        {
+            fprintf(stderr, "The server closed the connection after %lld answers\n", received);
+            c->failed = true;
+            break;
+        }
+        
+        if(header.status == STATUS_OK && is_delta(c, header.id))
+        {
+            uint64_t version;
+            if(fread(&version, sizeof(version), 1, in) != 1)
+            {
+                c->failed = true;
+                break;
+            }
+            c->deltas++;
+        }
+        else if(header.status == STATUS_OK)
+        {
+            Result_Record record;
+            if(fread(&record, sizeof(record), 1, in) != 1)
+            {
+                c->failed = true;
+                break;
+            }
+            
+            // the directions aren't checked, only read
+            char skip[256];
+            for(uint32_t left = record.packed_len ; left > 0 ; )
+            {
+                size_t n = left < sizeof(skip) ? left : sizeof(skip);
+                if(fread(skip, 1, n, in) != n)
+                    break;
+                left -= n;
+            }
+            
+            if(record.cost < 0)
+                c->not_found++;
+        }
+        else
+        {
+            c->bad_requests++;
+        }
+        
+        c->latencies[received++] = now_us() - sent_at[header.id];
+    }
+    
+    free(sent_at);
+    fclose(out);
+    fclose(in);
+    return NULL;
+}
+
+int run_client(const char *socket_path, const char *queries_path, Client_Options options)
+{
+    int nb_queries;
+    Query_Request *queries = read_queries(queries_path, &nb_queries);
+    if(queries == NULL)
+        return 1;
+    
+    if(options.connections <= 0)
+        options.connections = 1;
+    if(options.pipeline <= 0)
+        options.pipeline = 1;
+    if(options.requests <= 0)
+        options.requests = nb_queries;
+    if(options.requests < options.connections)
+        options.connections = options.requests;
+    
+    // the cells deltas change are within the points of the queries, so they're within the map
+    int max_x = 0;
+    int max_y = 0;
+    for(int i = 0 ; i < nb_queries ; i++)
+    {
+        max_x = max_x > queries[i].start_x ? max_x : queries[i].start_x;
+        max_x = max_x > queries[i].end_x   ? max_x : queries[i].end_x;
+        max_y = max_y > queries[i].start_y ? max_y : queries[i].start_y;
+        max_y = max_y > queries[i].end_y   ? max_y : queries[i].end_y;
+    }
+    
+    // the requests are split evenly between the connections, and the latencies are gathered in one array
+    double *latencies = (double*) malloc(options.requests * sizeof(double));
+    Client_Conn *conns = (Client_Conn*) calloc(options.connections, sizeof(Client_Conn));
+    pthread_t *threads = (pthread_t*) malloc(options.connections * sizeof(pthread_t));
+    
+    long long offset = 0;
+    for(int i = 0 ; i < options.connections ; i++)
+    {
+        conns[i] = (Client_Conn){
+            .socket_path = socket_path,
+            .queries     = queries,
+            .nb_queries  = nb_queries,
+            .first_query = (int) ((long long) i * nb_queries / options.connections),
+            .requests    = options.requests / options.connections + (i < options.requests % options.connections),
+            .pipeline    = options.pipeline,
+            .encode      = options.encode,
+            .delta_every = options.delta_every,
+            .max_x       = max_x,
+            .max_y       = max_y,
+            .latencies   = latencies + offset
+        };
+        offset += conns[i].requests;
+    }
+    
+    const double begin = now_us();
+    for(int i = 0 ; i < options.connections ; i++)
+        pthread_create(&threads[i], NULL, drive_connection, &conns[i]);
+    for(int i = 0 ; i < options.connections ; i++)
+        pthread_join(threads[i], NULL);
+    const double elapsed = now_us() - begin;
+    
+    long long not_found = 0;
+    long long bad_requests = 0;
+    long long deltas = 0;
+    bool failed = false;
+    for(int i = 0 ; i < options.connections ; i++)
+    {
+        not_found    += conns[i].not_found;
+        bad_requests += conns[i].bad_requests;
+        deltas       += conns[i].deltas;
+        failed = failed || conns[i].failed;
+    }
+    
+    if(!failed)
+    {
+        const long long n = options.requests;
+        qsort(latencies, n, sizeof(double), compare_doubles);
+        
+        double total = 0;
+        for(long long i = 0 ; i < n ; i++)
+            total += latencies[i];
+        
+        printf("%lld requests over %d connections, %d in flight each\n", n, options.connections, options.pipeline);
+        printf("no path: %lld, bad requests: %lld, deltas: %lld\n", not_found, bad_requests, deltas);
+        printf("throughput: %.0f queries/s\n", n / (elapsed / 1e6));
+        printf("latency (us): mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+               total / n, latencies[n / 2], latencies[n * 90 / 100], latencies[n * 99 / 100],
+               latencies[n * 999 / 1000], latencies[n - 1]);
+    }
+    
+    free(threads);
+    free(conns);
+    free(latencies);
+    free(queries);
+    return failed;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/grid_file.h"
+
+#ifdef PATH_FINDER_TILED
+#define GRID_FILE_LAYOUT GRID_FILE_TILED
+#else
+#define GRID_FILE_LAYOUT 0
+#endif
+
+// checks that a header describes a valid grid in a file of 'file_size' bytes
+static bool valid_header(const Grid_File_Header *header, size_t file_size, const char *path)
+{
+    if(memcmp(header->magic, GRID_FILE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        fprintf(stderr, "'%s' is not a grid file\n", path);
+        return false;
+    }
+    if(header->version != GRID_FILE_VERSION)
+    {
+        fprintf(stderr, "'%s' has unsupported version %u\n", path, header->version);
+        return false;
+    }
+    if((header->flags & GRID_FILE_TILED) != GRID_FILE_LAYOUT)
+    {
+        fprintf(stderr, "'%s' was saved with a different grid layout than this build uses\n", path);
+        return false;
+    }
+    if(header->cols <= 0 || header->rows <= 0)
+    {
+        fprintf(stderr, "'%s' has invalid dimensions %dx%d\n", path, header->cols, header->rows);
+        return false;
+    }
+    // the offset and size are checked one at a time against the file size, so a huge offset can't wrap around
+    // the offset is page aligned like save_grid_file writes it, so the payload starts on a page of the mapping
+    if(header->payload_size != (uint64_t) grid_size(header->cols, header->rows)
+       || header->payload_offset < sizeof(Grid_File_Header)
+       || header->payload_offset % GRID_FILE_PAYLOAD_OFFSET != 0
+       || header->payload_offset > file_size
+       || header->payload_size > file_size - header->payload_offset)
+    {
+        fprintf(stderr, "'%s' is truncated or corrupted\n", path);
+        return false;
+    }
+    
+    return true;
+}
+
+// turns every byte of the payload other than 0 and 1 into 1, since reading them as bool is undefined
+// any other writer may have saved passable cells as other non zero bytes, which the GUI reads as passable too
+// the payload is read in words, and only the pages holding such bytes are written, so only they are copied
+static void normalize_payload(unsigned char *payload, size_t size)
+{
+    const uint64_t not_bool = 0xFEFEFEFEFEFEFEFEULL;
+    size_t i = 0;
+    for( ; i + sizeof(uint64_t) <= size ; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, payload + i, sizeof(word));
+        if((word & not_bool) == 0)
+            continue;
+        
+        for(size_t j = i ; j < i + sizeof(uint64_t) ; j++)
+            payload[j] = payload[j] != 0;
+    }
+    
+    for( ; i < size ; i++)
+    {
+        if(payload[i] > 1)
+            payload[i] = 1;
+    }
+}
+
+bool map_grid_file(const char *path, Grid_File *file)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd == -1)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    struct stat st;
+    if(fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(Grid_File_Header))
+    {
+        fprintf(stderr, "'%s' is not a grid file\n", path);
+        close(fd);
+        return false;
+    }
+    
+    // the mapping is private, so the grid can be written to (e.g. to make start/end passable) without changing the file
+    void *mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "Can't map '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    const Grid_File_Header *header = (const Grid_File_Header*) mapping;
+    if(!valid_header(header, st.st_size, path))
+    {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+    
+#ifdef MADV_HUGEPAGE
+    // ask for huge pages where supported, a search touches the whole payload so this saves a lot of TLB misses
+    // failing is fine, the mapping just stays on normal pages
+    madvise(mapping, st.st_size, MADV_HUGEPAGE);
+#endif
+    
+    normalize_payload((unsigned char*) mapping + header->payload_offset, header->payload_size);
+    
+    *file = (Grid_File){
+        .cols  = header->cols,
+        .rows  = header->rows,
+        .start = {header->start_x, header->start_y},
+        .end   = {header->end_x, header->end_y},
+        .grid  = (bool*) ((char*) mapping + header->payload_offset),
+        .mapping = mapping,
+        .mapping_size = st.st_size
+    };
+    
+    return true;
+}
+
+void unmap_grid_file(Grid_File *file)
+{
+    munmap(file->mapping, file->mapping_size);
+    *file = (Grid_File){0};
+}
+
+bool save_grid_file(const char *path, const bool *grid, int cols, int rows, Loc start, Loc end)
+{
+    FILE *f = fopen(path, "wb");
+    if(f == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    Grid_File_Header header = {
+        .version = GRID_FILE_VERSION,
+        .flags   = GRID_FILE_LAYOUT,
+        .cols    = cols,
+        .rows    = rows,
+        .start_x = start.x,
+        .start_y = start.y,
+        .end_x   = end.x,
+        .end_y   = end.y,
+        .payload_offset = GRID_FILE_PAYLOAD_OFFSET,
+        .payload_size   = grid_size(cols, rows)
+    };
+    memcpy(header.magic, GRID_FILE_MAGIC, sizeof(header.magic));
+    
+    // the header is padded with zeros up to the payload offset
+    static const char padding[GRID_FILE_PAYLOAD_OFFSET] = {0};
+    
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+           && fwrite(padding, GRID_FILE_PAYLOAD_OFFSET - sizeof(header), 1, f) == 1
+           && fwrite(grid, header.payload_size, 1, f) == 1;
+    
+    if(fclose(f) != 0 || !ok)
+    {
+        fprintf(stderr, "Can't write '%s'\n", path);
+        return false;
+    }
+    
+    return true;
+}
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/grid_parser.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+bool read_input(int fd, Input *input)
+{
+    struct stat st;
+    
+    // a regular file is mapped, so it doesn't have to be copied
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+#endif
+            *input = (Input){.data = data, .len = st.st_size, .mapped = true};
+            return true;
+        }
+    }
+    
+    // pipes and terminals are read in big chunks until the end
+    size_t cap = 1 << 20;
+    size_t len = 0;
+    char *data = (char*) malloc(cap);
+    ssize_t got;
+    while((got = read(fd, data + len, cap - len)) != 0)
+    {
+        if(got == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            fprintf(stderr, "Can't read the input: %s\n", strerror(errno));
+            free(data);
+            return false;
+        }
+        
+        len += got;
+        if(len == cap)
+        {
+            cap *= 2;
+            data = (char*) realloc(data, cap);
+        }
+    }
+    
+    *input = (Input){.data = data, .len = len, .mapped = false};
+    return true;
+}
+
+void free_input(Input *input)
+{
+    if(input->mapped)
+        munmap((void*) input->data, input->len);
+    else
+        free((void*) input->data);
+    *input = (Input){0};
+}
+
+// returns the offset of the first occurrence of 'upper' or 'lower' in the data, or -1 if there is none
+static ptrdiff_t find_first(const char *data, size_t len, char upper, char lower)
+{
+    const char *found = (const char*) memchr(data, upper, len);
+    
+    // the lower case letter only needs to be looked for before the upper case one
+    const char *found_lower = (const char*) memchr(data, lower, found ? (size_t) (found - data) : len);
+    if(found_lower != NULL)
+        found = found_lower;
+    
+    return found ? found - data : -1;
+}
+
+// converts the characters of a row from 'from' to 'to' to passability one at a time, writing them to 'out'
+// returns the offset of the first invalid character, or -1 if they are all valid
+static ptrdiff_t convert_chars(const char *row, bool *out, int from, int to, ptrdiff_t start, ptrdiff_t end)
+{
+    for(int i = from ; i < to ; i++)
+    {
+        const char c = row[i];
+        if(c == '0' || c == '1')
+        {
+            out[i] = c == '1';
+        }
+        else if(i == start || i == end)
+        {
+            // the start/end points are passable
+            out[i] = true;
+        }
+        else
+        {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+// converts 'n' characters of a row to passability, writing them to 'out'
+// 'start' and 'end' are the offsets of the start/end point relative to the row, the only other characters allowed
+// returns the offset of the first invalid character, or -1 if the row is valid
+static ptrdiff_t convert_row(const char *row, bool *out, int n, ptrdiff_t start, ptrdiff_t end)
+{
+    int i = 0;
+    
+#ifdef __SSE2__
+    // 16 characters at a time: subtracting '0' turns '0'/'1' into 0/1, which is what a bool holds
+    // a chunk with anything else is converted one character at a time, and the next chunks go back to 16 at a time
+    const __m128i zeros = _mm_set1_epi8('0');
+    const __m128i ones  = _mm_set1_epi8(1);
+    for( ; i + 16 <= n ; i += 16)
+    {
+        __m128i chunk = _mm_sub_epi8(_mm_loadu_si128((const __m128i*) (row + i)), zeros);
+        
+        // the values are unsigned, so any character other than '0'/'1' is bigger than 1
+        __m128i valid = _mm_cmpeq_epi8(_mm_max_epu8(chunk, ones), ones);
+        if(_mm_movemask_epi8(valid) != 0xFFFF)
+        {
+            ptrdiff_t invalid = convert_chars(row, out, i, i + 16, start, end);
+            if(invalid != -1)
+                return invalid;
+            continue;
+        }
+        
+        _mm_storeu_si128((__m128i*) (out + i), chunk);
+    }
+#endif
+    
+    return convert_chars(row, out, i, n, start, end);
+}
+
+bool *parse_grid(const char *data, size_t len, int cols, int rows, Loc *start, Loc *end, const char **line_end)
+{
+    *start = (Loc){-1, -1};
+    *end   = (Loc){-1, -1};
+    
+    // the start/end points are searched for in the whole grid at once
+    // any other start/end letter is then an unexpected character when its row is converted
+    // each row takes at most 'cols' characters and a "\r\n"
+    size_t grid_len = (size_t) rows * (cols + 2);
+    if(grid_len > len)
+        grid_len = len;
+    
+    ptrdiff_t start_offset = find_first(data, grid_len, 'S', 's');
+    ptrdiff_t end_offset   = find_first(data, grid_len, 'E', 'e');
+    
+    // zeroed, so the padding of the tiles that no row is written to is unpassable, and saved as such by --save
+    bool *grid = (bool*) calloc(grid_size(cols, rows), sizeof(bool));
+    if(grid == NULL)
+    {
+        fprintf(stderr, "Can't allocate a %dx%d grid\n", cols, rows);
+        return NULL;
+    }
+    
+#ifdef PATH_FINDER_TILED
+    // rows are converted into a contiguous buffer, and then copied to the tiles they span
+    bool *row_buffer = (bool*) malloc(cols * sizeof(bool));
+    if(row_buffer == NULL)
+    {
+        fprintf(stderr, "Can't allocate a row of %d cells\n", cols);
+        goto fail;
+    }
+#endif
+    
+    const char *row = data;
+    const char *data_end = data + len;
+    for(int i = 0 ; i < rows ; i++)
+    {
+        if(data_end - row < cols)
+        {
+            fprintf(stderr, "Reached the end of the input at row #%d of %d\n", i + 1, rows);
+            goto fail;
+        }
+        
+#ifdef PATH_FINDER_TILED
+        bool *out = row_buffer;
+#else
+        bool *out = &grid_get_at(grid, cols, ((Loc){0, i}));
+#endif
+        
+        // the offsets of the start/end relative to the row
+        const ptrdiff_t row_start = start_offset - (row - data);
+        const ptrdiff_t row_end   = end_offset   - (row - data);
+        
+        ptrdiff_t invalid = convert_row(row, out, cols, row_start, row_end);
+        if(invalid != -1 && (row[invalid] == '\n' || row[invalid] == '\r'))
+        {
+            fprintf(stderr, "Expected %d values at row #%d, got %d\n", cols, i + 1, (int) invalid);
+            goto fail;
+        }
+        if(invalid != -1)
+        {
+            fprintf(stderr, "Unexpected character '%c' at row #%d, col #%d\n", row[invalid], i + 1, (int) invalid + 1);
+            goto fail;
+        }
+        
+        if(row_start >= 0 && row_start < cols)
+            *start = (Loc){.x = row_start, .y = i};
+        if(row_end >= 0 && row_end < cols)
+            *end = (Loc){.x = row_end, .y = i};
+        
+#ifdef PATH_FINDER_TILED
+        for(int j = 0 ; j < cols ; j += TILE_SIZE)
+        {
+            int n = cols - j < TILE_SIZE ? cols - j : TILE_SIZE;
+            memcpy(&grid_get_at(grid, cols, ((Loc){j, i})), row_buffer + j, n);
+        }
+#endif
+        
+        // every row ends with a newline, except the last one which may end the input
+        const char *after = row + cols;
+        if(after < data_end && *after == '\r')
+            after++;
+        if(after < data_end && *after == '\n')
+            after++;
+        else if(after != data_end || i != rows - 1)
+        {
+            fprintf(stderr, "Expected %d values at row #%d, got more\n", cols, i + 1);
+            goto fail;
+        }
+        
+        row = after;
+    }
+    
+    *line_end = row;
+#ifdef PATH_FINDER_TILED
+    free(row_buffer);
+#endif
+    return grid;
+    
+    fail:
+#ifdef PATH_FINDER_TILED
+    free(row_buffer);
+#endif
+    free(grid);
+    return NULL;
+}
+
+bool *parse_grid_input(const Input *input, int *cols, int *rows, Loc *start, Loc *end)
+{
+    const char *p = input->data;
+    const char *data_end = input->data + input->len;
+    
+    // the number of rows and cols come first, each on its own line
+    int *dims[2] = {rows, cols};
+    for(int i = 0 ; i < 2 ; i++)
+    {
+        long n = 0;
+        while(p < data_end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+        while(p < data_end && *p >= '0' && *p <= '9' && n <= 1 << 30)
+            n = n * 10 + (*p++ - '0');
+        
+        if(n <= 0 || n > 1 << 30)
+        {
+            fprintf(stderr, "The number of %s must be a positive number\n", i == 0 ? "rows" : "cols");
+            return NULL;
+        }
+        *dims[i] = n;
+        
+        // skip the rest of the line
+        while(p < data_end && *p != '\n')
+            p++;
+        if(p < data_end)
+            p++;
+    }
+    
+    const char *line_end;
+    bool *grid = parse_grid(p, data_end - p, *cols, *rows, start, end, &line_end);
+    if(grid == NULL)
+        return NULL;
+    
+    if(start->x == -1 || end->x == -1)
+    {
+        fprintf(stderr, "%s point wasn't set\n", start->x == -1 ? "Start" : "End");
+        free(grid);
+        return NULL;
+    }
+    
+    return grid;
+}
@@ -2,32 +2,312 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <uchar.h>
-#include <locale.h>
+#include <unistd.h>
 #include "../include/path_finder.h"
+#include "../include/any_angle.h"
+#include "../include/grid_file.h"
+#include "../include/out_of_core.h"
+#include "../include/batch.h"
+#include "../include/movingai.h"
+#include "../include/grid_parser.h"
+#include "../include/render.h"
+#include "../include/result.h"
+#include "../include/server.h"
 
 bool char_to_bool(char c);
 int read_int(const char* prompt);
-void print_path(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows);
 bool *read_grid(int rows, int cols, Loc *start, Loc *end);
+void print_waypoints(Waypoints *waypoints);
 
-int main()
+// the options the program accepts, printed when an unknown option is given
+const char *usage =
+"Usage: %s [options]\n"
+"  --any-angle    also print the path shortened to straight legs\n"
+"  --load FILE    read the grid and the start/end points from a binary grid file\n"
+"  --save FILE    write the grid and the start/end points to a binary grid file\n"
+"  --out-of-core MB  keep at most MB megabytes of the search state in memory, paging the rest to disk\n"
+"                    the frontier counts against MB, the search fails if it outgrows it\n"
+"  --scratch FILE    the file the search state is paged to (default: a temporary file)\n"
+"  --map FILE --queries FILE  answer every \"start_x start_y end_x end_y\" line of the queries file on the map\n"
+"  --encode       in batch mode, also print the directions of each path\n"
+"  --stats        print what the search did to stderr: nodes expanded, queue operations and times\n"
+"  --format FORMAT  write results as text (default), json lines or binary records\n"
+"  --serve SOCKET --map FILE [--threads N]  answer queries sent to a Unix domain socket on the map\n"
+"  --client SOCKET --queries FILE [--connections N] [--pipeline N] [--requests N] [--delta-every N]\n"
+"                 send the queries to a server and print the throughput and latency\n"
+"  --scen FILE [--map FILE]   run a MovingAI scenario file, checking every cost against the optimal length\n"
+"  --crop MARGIN  only print the part of the grid around the path, with MARGIN cells around it\n"
+"  --overview WIDTH  print a downsampled overview of the grid at most WIDTH characters wide\n";
+
+int main(int argc, char **argv)
 {
-    const int rows = read_int("Number of rows: ");
-    const int cols = read_int("Number of cols: ");
+    // when set, the path is also shortened to straight legs and printed as waypoints
+    bool any_angle = false;
+    
+    // the binary grid files to read the grid from and write it to, if given
+    const char *load_path = NULL;
+    const char *save_path = NULL;
+    
+    // when set, the search keeps a bounded amount of its state in memory
+    bool out_of_core = false;
+    Out_Of_Core_Options out_of_core_options = {0};
+    
+    // the files of the batch mode, and whether the paths are printed in it
+    const char *map_path     = NULL;
+    const char *queries_path = NULL;
+    bool encode = false;
+    
+    // the socket of the query server mode, and how many threads answer its queries (0 for one per core)
+    const char *serve_path = NULL;
+    int nb_threads = 0;
+    
+    // the socket of the load generator mode, and how it drives the server
+    const char *client_path = NULL;
+    Client_Options client_options = {.connections = 1, .pipeline = 1};
+    
+    // when set, the search stats are printed to stderr
+    bool print_search_stats = false;
+    
+    // how results are written, anything but text leaves out the grid and writes a record instead
+    Output_Format format = FORMAT_TEXT;
+    
+    // how the grid is printed, -1 when not cropped or overviewed
+    int crop_margin    = -1;
+    int overview_width = -1;
+    
+    // the MovingAI scenario file to run, its maps are .map files
+    const char *scen_path = NULL;
+    
+    for(int i = 1 ; i < argc ; i++)
+    {
+        if(strcmp(argv[i], "--any-angle") == 0)
+        {
+            any_angle = true;
+        }
+        else if(strcmp(argv[i], "--load") == 0 && i + 1 < argc)
+        {
+            load_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+        {
+            save_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--out-of-core") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            out_of_core = true;
+            out_of_core_options.max_resident_bytes = (size_t) atoi(argv[++i]) << 20;
+        }
+        else if(strcmp(argv[i], "--scratch") == 0 && i + 1 < argc)
+        {
+            out_of_core_options.scratch_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+        {
+            map_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+        {
+            queries_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--scen") == 0 && i + 1 < argc)
+        {
+            scen_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--crop") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0)
+        {
+            crop_margin = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--overview") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            overview_width = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc && parse_output_format(argv[i + 1], &format))
+        {
+            i++;
+        }
+        else if(strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+        {
+            serve_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            nb_threads = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--client") == 0 && i + 1 < argc)
+        {
+            client_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--connections") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            client_options.connections = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            client_options.pipeline = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--requests") == 0 && i + 1 < argc && atoll(argv[i + 1]) > 0)
+        {
+            client_options.requests = atoll(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--delta-every") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            client_options.delta_every = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--stats") == 0)
+        {
+            print_search_stats = true;
+        }
+        else if(strcmp(argv[i], "--encode") == 0)
+        {
+            encode = true;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            fprintf(stderr, usage, argv[0]);
+            return 1;
+        }
+    }
     
+    // the map of a scenario run is optional, by default the maps are found next to the scenario file
+    if(scen_path != NULL)
+    {
+        return run_scenarios(scen_path, map_path);
+    }
+    
+    // the server loads the map once and answers queries until it's killed
+    if(serve_path != NULL)
+    {
+        if(map_path == NULL)
+        {
+            fprintf(stderr, "--serve needs a --map\n");
+            return 1;
+        }
+        return run_server(map_path, serve_path, nb_threads);
+    }
+    
+    if(client_path != NULL)
+    {
+        if(queries_path == NULL)
+        {
+            fprintf(stderr, "--client needs a --queries file\n");
+            return 1;
+        }
+        client_options.encode = encode;
+        return run_client(client_path, queries_path, client_options);
+    }
+    
+    // in batch mode, there are no prompts and the grid is loaded once for all the queries
+    if(map_path != NULL || queries_path != NULL)
+    {
+        if(map_path == NULL || queries_path == NULL)
+        {
+            fprintf(stderr, "--map and --queries must be given together\n");
+            return 1;
+        }
+        return run_batch(map_path, queries_path, encode, format, print_search_stats);
+    }
+    
+    int rows;
+    int cols;
     Loc start = {-1, -1};
     Loc end   = {-1, -1};
+    bool *grid;
     
-    // start and end are assigned as output parameters
-    bool *grid = read_grid(rows, cols, &start, &end);
+    // a grid file is mapped instead of read, so huge grids load without parsing
+    Grid_File file = {0};
+    if(load_path != NULL)
+    {
+        if(!map_grid_file(load_path, &file))
+            return 1;
+        
+        rows  = file.rows;
+        cols  = file.cols;
+        start = file.start;
+        end   = file.end;
+        grid  = file.grid;
+        
+        if(!in_range(start, cols, rows) || !in_range(end, cols, rows))
+        {
+            fprintf(stderr, "'%s' doesn't have a start and end point\n", load_path);
+            unmap_grid_file(&file);
+            return 1;
+        }
+    }
+    else if(!isatty(STDIN_FILENO))
+    {
+        // piped input is read and parsed in bulk, without any prompts
+        Input input;
+        if(!read_input(STDIN_FILENO, &input))
+            return 1;
+        
+        grid = parse_grid_input(&input, &cols, &rows, &start, &end);
+        free_input(&input);
+        
+        if(grid == NULL)
+            return 1;
+    }
+    else
+    {
+        rows = read_int("Number of rows: ");
+        cols = read_int("Number of cols: ");
+        
+        // start and end are assigned as output parameters
+        grid = read_grid(rows, cols, &start, &end);
+    }
     
-    Path *path = shortest_path(grid, cols, rows, start, end);
+    if(save_path != NULL && !save_grid_file(save_path, grid, cols, rows, start, end))
+    {
+        return 1;
+    }
     
-    print_path(path, start, end, grid, cols, rows);
+    Search_Stats stats = {0};
+    Path *path = NULL;
+    if(out_of_core)
+    {
+        // a failed scratch file says nothing about the path, so it's an error rather than "no path"
+        if(!shortest_path_out_of_core(grid, cols, rows, start, end, out_of_core_options, &path))
+            return 1;
+    }
+    else
+        path = shortest_path_with_stats(grid, cols, rows, start, end, &stats);
+    
+    if(format != FORMAT_TEXT)
+    {
+        // a single record with the whole path, for other programs to read
+        static Out_Buf out;
+        out.f = stdout;
+        write_result(&out, format, path != NULL, path ? path->cost : 0, path ? path->nb : 0, path ? path->dirs : NULL);
+        out_flush(&out);
+    }
+    else if(overview_width != -1)
+        print_overview(path, start, end, grid, cols, rows, overview_width);
+    else if(crop_margin != -1)
+        print_path_window(path, start, end, grid, cols, path_window(path, start, crop_margin, cols, rows));
+    else
+        print_path(path, start, end, grid, cols, rows);
+    
+    if(any_angle && path != NULL && format == FORMAT_TEXT)
+    {
+        Waypoints *waypoints = smooth_path(path, start, grid, cols);
+        print_waypoints(waypoints);
+        free(waypoints);
+    }
+    
+    // the stats go to stderr, so they don't mix with the result
+    if(print_search_stats)
+    {
+        if(out_of_core)
+            fprintf(stderr, "search stats aren't counted by the out-of-core search\n");
+        else
+            print_stats(stderr, &stats, 1);
+    }
     
     // cleanup
-    free(grid);
+    if(load_path != NULL)
+        unmap_grid_file(&file);
+    else
+        free(grid);
     free(path);
 }
 
@@ -39,7 +319,7 @@ bool *read_grid(int rows, int cols, Loc *start, Loc *end)
     int end_set_on_line   = -1;
     
     // the obstacles grid, true is passable, false is unpassable
-    bool *grid = (bool*) calloc(rows * cols, sizeof(bool));
+    bool *grid = (bool*) calloc(grid_size(cols, rows), sizeof(bool));
     
     // allocating cols + 2 for '\0' and one more char to check if user inputted a larger string than needed
     const int max_line_len = cols + 2;
@@ -98,19 +378,19 @@ bool *read_grid(int rows, int cols, Loc *start, Loc *end)
             if(line[j] == '1' || line[j] == '0')
             {
                 // turn '0' to false and '1' to true, then insert into grid
-                grid[i * cols + j] = char_to_bool(line[j]);
+                grid_get_at(grid, cols, ((Loc){j, i})) = char_to_bool(line[j]);
             }
             else if((line[j] == 'S' || line[j] == 's') && start_set_on_line == -1)
             {
                 // make start point passable on the grid
-                grid[i * cols + j] = true;
+                grid_get_at(grid, cols, ((Loc){j, i})) = true;
                 *start = (Loc){.x = j, .y = i};
                 start_set_on_line = i;
             }
             else if((line[j] == 'E' || line[j] == 'e') && end_set_on_line == -1)
             {
                 // make end point passable on the grid
-                grid[i * cols + j] = true;
+                grid_get_at(grid, cols, ((Loc){j, i})) = true;
                 *end = (Loc){.x = j, .y = i};
                 end_set_on_line = i;
             }
@@ -174,131 +454,13 @@ int read_int(const char *prompt)
     }
 }
 
-// prints the obstacles grid and the path from start to end if found
-void print_path(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows)
+// prints the any-angle cost and the waypoints of a smoothed path
+void print_waypoints(Waypoints *waypoints)
 {
-    if(path == NULL)
+    printf("any-angle cost: %.2f\n\nwaypoints:", waypoints->cost);
+    for(int i = 0 ; i < waypoints->nb ; i++)
     {
-        puts("\nno path found");
-        return;
+        printf(" (%d, %d)", waypoints->locs[i].x, waypoints->locs[i].y);
     }
-    
-    // set the locale to utf8
-    // making utf32 characters assignable to char* by taking 4 bytes
-    setlocale(LC_ALL, "en_US.utf8");
-    
-    // each cell needs 2 chars:
-    // one for the '|' to the right of it
-    // one for the cell itself
-    // +
-    // each row needs 2 char:
-    // starts with '|'
-    // ends with a '\n'
-    // +
-    // 1 nul character to terminate the string
-    const int grid_str_size = (cols * rows) * 2 + (2 * rows) + 1;
-    char32_t *grid_str32 = (char32_t*) calloc(grid_str_size, sizeof(char32_t));
-    const int row_len = 2 * cols + 2; // including the \n
-    
-    // this array is used to go from bool to cell, such that:
-    // obstacles_chars[false] = '🞨'
-    // obstacles_chars[true]  = ' '
-    const char32_t obstacles_chars[2] = {U'🞨', U' '};
-    
-    // this loop sets the obstacles on the grid string
-    for(int i = 0 ; i < rows ; i++)
-    {
-        // the leftmost '|' of each line
-        grid_str32[i * row_len] = U'|';
-        
-        // the cell followed by a '|' to the right of it
-        for(int j = 0 ; j < cols ; j++)
-        {
-            char32_t char_at_cell = obstacles_chars[grid_get_at(obstacles, cols, ((Loc){j, i}))];
-            grid_str32[i * row_len + (j * 2) + 1] = char_at_cell;
-            grid_str32[i * row_len + (j * 2) + 2] = U'|';
-        }
-        
-        // a newline to end the row
-        grid_str32[i * row_len + row_len - 1] = U'\n';
-    }
-    
-    // set the start and end on the grid string
-    grid_str32[start.y * row_len + (start.x * 2) + 1] = U'S';
-    grid_str32[end.y   * row_len + (end.x   * 2) + 1] = U'E';
-    
-    Loc current;
-    
-    // ignore the first direction (start to second cell), as it won't be printed ('S' already there)
-    if(path->nb > 0)
-    {
-        current = next_loc(start, path->dirs[0]);
-    }
-    
-    // loop over the directions in the path, not including the first direction
-    for(int i = 1 ; i < path->nb ; ++i)
-    {
-        // set an arrow pointing to its parent in each cell in path
-        // then update the current location to the next location on the path
-        switch(path->dirs[i])
-        {
-            case UP:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡑';
-                current.y--;
-                break;
-            case UP_RIGHT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡕';
-                current.y--;
-                current.x++;
-                break;
-            case RIGHT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡒';
-                current.x++;
-                break;
-            case DOWN_RIGHT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡖';
-                current.y++;
-                current.x++;
-                break;
-            case DOWN:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡓';
-                current.y++;
-                break;
-            case DOWN_LEFT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡗';
-                current.y++;
-                current.x--;
-                break;
-            case LEFT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡐';
-                current.x--;
-                break;
-            case UP_LEFT:
-                grid_str32[current.y * row_len + (current.x * 2) + 1] = U'🡔';
-                current.y--;
-                current.x--;
-                break;
-            default:
-                fprintf(stderr, "Unexpected direction of value '%d'\n", path->dirs[i]);
-                exit(1);
-                break;
-        }
-    }
-    
-    // turn the utf32 string to a utf8 string so it can be printed
-    char *grid_str = (char*) calloc(grid_str_size * MB_CUR_MAX, sizeof(char));
-    char *temp = grid_str;
-    mbstate_t state = {0};
-    for(int i = 0 ; i < grid_str_size ; i++)
-    {
-        temp += c32rtomb(temp, grid_str32[i], &state);
-    }
-    
-    printf("\ncost: %.2f\n", path->cost);
-    printf("\n%s\n", grid_str);
-    
-    // cleanup
-    free(grid_str32);
-    free(grid_str);
+    printf("\n");
 }
-
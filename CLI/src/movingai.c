@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include "../include/movingai.h"
+#include "../include/path_finder.h"
+#include "../include/result.h"
+
+// Returns the length of the path of a search that found one, summed in double
+static double path_length(const Search *search)
+{
+    double length = 0;
+    
+    Path_Iter iter = path_iter(search);
+    Parent_Direction dir;
+    while(path_iter_next(&iter, &dir))
+        length += dir >= UP_RIGHT ? M_SQRT2 : 1;
+    
+    return length;
+}
+
+bool *read_movingai_map(const char *path, int *cols, int *rows)
+{
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    
+    // the header is "type octile", "height H", "width W" and "map", one per line
+    char type[32];
+    if(fscanf(f, " type %31s height %d width %d map", type, rows, cols) != 3 || *rows <= 0 || *cols <= 0)
+    {
+        fprintf(stderr, "'%s' is not a MovingAI map\n", path);
+        fclose(f);
+        return NULL;
+    }
+    
+    bool *grid = (bool*) calloc(grid_size(*cols, *rows), sizeof(bool));
+    char *line = (char*) malloc(*cols + 2);
+    
+    for(int i = 0 ; i < *rows ; i++)
+    {
+        // skip the newline left after the header or the previous row
+        int c;
+        while((c = getc(f)) == '\n' || c == '\r');
+        ungetc(c, f);
+        
+        if(fread(line, 1, *cols, f) != (size_t) *cols)
+        {
+            fprintf(stderr, "'%s' has fewer rows than its height of %d\n", path, *rows);
+            free(line);
+            free(grid);
+            fclose(f);
+            return NULL;
+        }
+        
+        for(int j = 0 ; j < *cols ; j++)
+        {
+            grid_get_at(grid, *cols, ((Loc){j, i})) = line[j] == '.' || line[j] == 'G' || line[j] == 'S';
+        }
+    }
+    
+    free(line);
+    fclose(f);
+    return grid;
+}
+
+// compares two doubles for qsort
+static int compare_doubles(const void *a, const void *b)
+{
+    double l = *(const double*) a;
+    double r = *(const double*) b;
+    return (l > r) - (l < r);
+}
+
+// returns the p'th percentile of sorted values
+static double percentile(const double *sorted, int nb, double p)
+{
+    int i = (int) ceil(p / 100 * nb) - 1;
+    return sorted[i < 0 ? 0 : i];
+}
+
+// writes the path of the map a scenario refers to into 'out'
+// the map is looked up in the directory of the scenario file, since scenario files name maps by their path in the benchmark set
+static void scenario_map_path(const char *scen_path, const char *map_name, char *out, size_t out_size)
+{
+    const char *map_base  = strrchr(map_name, '/');
+    const char *scen_base = strrchr(scen_path, '/');
+    map_base = map_base ? map_base + 1 : map_name;
+    
+    size_t dir_len = scen_base ? (size_t) (scen_base - scen_path + 1) : 0;
+    if(dir_len + strlen(map_base) >= out_size)
+    {
+        out[0] = '\0';
+        return;
+    }
+    memcpy(out, scen_path, dir_len);
+    strcpy(out + dir_len, map_base);
+}
+
+int run_scenarios(const char *scen_path, const char *map_path)
+{
+    FILE *scen = fopen(scen_path, "r");
+    if(scen == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", scen_path, strerror(errno));
+        return 1;
+    }
+    
+    // the first line is the version of the scenario file
+    double version;
+    if(fscanf(scen, " version %lf", &version) != 1)
+    {
+        fprintf(stderr, "'%s' is not a MovingAI scenario file\n", scen_path);
+        fclose(scen);
+        return 1;
+    }
+    
+    // the optimal lengths of the benchmarks don't allow cutting corners
+    Search search = { .no_corner_cutting = true };
+    
+    // the map that's currently loaded, reloaded only when a scenario refers to another one
+    char loaded_map[4096] = "";
+    bool *grid = NULL;
+    int cols = 0;
+    int rows = 0;
+    
+    int nb = 0;
+    int cap = 0;
+    int passed = 0;
+    bool map_failed = false;
+    double *times = NULL;
+    Search_Stats stats = {0};
+    
+    int bucket;
+    char map_name[4096];
+    int map_width;
+    int map_height;
+    Loc start;
+    Loc end;
+    double optimal;
+    while(fscanf(scen, "%d %4095s %d %d %d %d %d %d %lf", &bucket, map_name, &map_width, &map_height, &start.x, &start.y, &end.x, &end.y, &optimal) == 9)
+    {
+        char path[4096];
+        if(map_path != NULL)
+            snprintf(path, sizeof(path), "%s", map_path);
+        else
+            scenario_map_path(scen_path, map_name, path, sizeof(path));
+        
+        if(strcmp(path, loaded_map) != 0)
+        {
+            free(grid);
+            if((grid = read_movingai_map(path, &cols, &rows)) == NULL)
+            {
+                map_failed = true;
+                break;
+            }
+            strcpy(loaded_map, path);
+        }
+        
+        if(!in_range(start, cols, rows) || !in_range(end, cols, rows))
+        {
+            fprintf(stderr, "scenario #%d: (%d, %d) -> (%d, %d) is outside the %dx%d map\n", nb + 1, start.x, start.y, end.x, end.y, cols, rows);
+            map_failed = true;
+            break;
+        }
+        
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        find_path(&search, grid, cols, rows, start, end);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        
+        if(nb == cap)
+        {
+            cap = cap ? cap * 2 : 1024;
+            times = (double*) realloc(times, cap * sizeof(double));
+        }
+        times[nb] = (after.tv_sec - before.tv_sec) * 1e6 + (after.tv_nsec - before.tv_nsec) / 1e3;
+        nb++;
+        
+        stats_merge(&stats, &search.stats);
+        
+        // the search sums its costs as floats, which drift from the optimal length over thousands of steps
+        // so the length of the path it found is summed again in double, and compared with the precision of the scenario file
+        const double tolerance = 1e-5 * (optimal > 1 ? optimal : 1) + 1e-4;
+        const double cost = search.found ? path_length(&search) : -1;
+        if(fabs(cost - optimal) > tolerance)
+        {
+            fprintf(stderr, "scenario #%d: (%d, %d) -> (%d, %d) on '%s': cost %.4f, expected %.4f\n", nb, start.x, start.y, end.x, end.y, map_name, cost, optimal);
+        }
+        else
+        {
+            passed++;
+        }
+    }
+    
+    printf("scenarios: %d, passed: %d, failed: %d\n", nb, passed, nb - passed);
+    
+    if(nb > 0)
+    {
+        double total = 0;
+        for(int i = 0 ; i < nb ; i++)
+            total += times[i];
+        qsort(times, nb, sizeof(double), compare_doubles);
+        
+        print_stats(stdout, &stats, nb);
+        printf("us per query: mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+               total / nb, percentile(times, nb, 50), percentile(times, nb, 90), percentile(times, nb, 99), times[nb - 1]);
+    }
+    
+    // cleanup
+    free(times);
+    free(grid);
+    free_search(&search);
+    fclose(scen);
+    
+    return map_failed || passed != nb;
+}
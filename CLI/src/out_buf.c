@@ -0,0 +1,33 @@
+#include <string.h>
+#include "../include/out_buf.h"
+
+void out_flush(Out_Buf *out)
+{
+    fwrite(out->data, 1, out->len, out->f);
+    out->len = 0;
+}
+
+void out_write(Out_Buf *out, const void *data, size_t len)
+{
+    const char *bytes = (const char*) data;
+    
+    while(len > 0)
+    {
+        if(out->len == OUT_BUF_SIZE)
+            out_flush(out);
+        
+        size_t n = OUT_BUF_SIZE - out->len;
+        if(n > len)
+            n = len;
+        
+        memcpy(out->data + out->len, bytes, n);
+        out->len += n;
+        bytes += n;
+        len -= n;
+    }
+}
+
+void out_puts(Out_Buf *out, const char *str)
+{
+    out_write(out, str, strlen(str));
+}
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/out_of_core.h"
+
+// A node as it is stored in a tile, smaller than Node so more of the grid fits in memory
+// the number of steps isn't stored, the path is walked once to count them instead
+typedef struct Paged_Node {
+    float cost;
+    unsigned char parent_dir;
+    bool visited;
+} Paged_Node;
+
+// A tile of the node grid that is currently in memory
+typedef struct Frame {
+    int tile; // -1 if the frame is empty
+    bool dirty;
+    unsigned long long last_used;
+    Paged_Node *nodes;
+} Frame;
+
+// the fewest frames kept in memory, a tile and its neighbours
+#define MIN_FRAMES 9
+
+// The node grid of an out of core search, split in square tiles that are paged in and out of a scratch file
+// square tiles follow the wavefront of the search much more closely than bands of whole rows would
+typedef struct Paged_Grid {
+    size_t max_resident_bytes; // shared by the frames and the frontier, frames are dropped as the frontier grows
+    int tile_size;
+    int tiles_per_row;
+    int nb_tiles;
+    size_t tile_bytes;
+    int fd;
+    FILE *scratch; // set if the scratch file is an anonymous temporary file
+    int *tile_frame;        // the frame each tile is in, -1 if it isn't in memory
+    bool *tile_initialized; // whether a tile was ever written to the scratch file
+    int nb_frames;
+    Frame *frames;
+    unsigned long long clock;
+} Paged_Grid;
+
+// An entry of the frontier, the node is referred to by location since it may not be in memory
+typedef struct Frontier_Entry {
+    float cost;
+    Loc loc;
+} Frontier_Entry;
+
+// A min-heap of frontier entries, growing as needed
+// nodes can be pushed more than once, the stale entries are skipped when popped
+typedef struct Frontier {
+    size_t size;
+    size_t cap;
+    Frontier_Entry *data;
+} Frontier;
+
+static bool reserve_frontier(Paged_Grid *pg, size_t frontier_bytes);
+
+// Returns false if the frontier can't grow within the memory ceiling, or if the scratch file failed while making room
+static bool frontier_push(Paged_Grid *pg, Frontier *f, float cost, Loc loc)
+{
+    if(f->size == f->cap)
+    {
+        const size_t cap = f->cap ? f->cap * 2 : 1024;
+        if(!reserve_frontier(pg, cap * sizeof(Frontier_Entry)))
+            return false;
+        
+        Frontier_Entry *data = (Frontier_Entry*) realloc(f->data, cap * sizeof(Frontier_Entry));
+        if(data == NULL)
+        {
+            fprintf(stderr, "Can't allocate a frontier of %zu entries\n", cap);
+            return false;
+        }
+        f->data = data;
+        f->cap  = cap;
+    }
+    
+    // sift the new entry up until its parent is cheaper
+    size_t current = f->size++;
+    while(current != 0 && f->data[(current - 1) / 2].cost > cost)
+    {
+        f->data[current] = f->data[(current - 1) / 2];
+        current = (current - 1) / 2;
+    }
+    f->data[current] = (Frontier_Entry){.cost = cost, .loc = loc};
+    return true;
+}
+
+static Frontier_Entry frontier_pop(Frontier *f)
+{
+    Frontier_Entry ret  = f->data[0];
+    Frontier_Entry last = f->data[--f->size];
+    
+    // sift the last entry down from the root until its children are more expensive
+    size_t current = 0;
+    while(2 * current + 1 < f->size)
+    {
+        size_t child = 2 * current + 1;
+        if(child + 1 < f->size && f->data[child + 1].cost < f->data[child].cost)
+            child++;
+        if(f->data[child].cost >= last.cost)
+            break;
+        f->data[current] = f->data[child];
+        current = child;
+    }
+    f->data[current] = last;
+    
+    return ret;
+}
+
+// writes a frame back to the scratch file if it was changed, and empties it
+static bool evict_frame(Paged_Grid *pg, Frame *frame)
+{
+    if(frame->tile == -1)
+    {
+        return true;
+    }
+    
+    if(frame->dirty)
+    {
+        off_t offset = (off_t) frame->tile * pg->tile_bytes;
+        if(pwrite(pg->fd, frame->nodes, pg->tile_bytes, offset) != (ssize_t) pg->tile_bytes)
+        {
+            fprintf(stderr, "Can't write to the scratch file: %s\n", strerror(errno));
+            return false;
+        }
+        pg->tile_initialized[frame->tile] = true;
+    }
+    
+    pg->tile_frame[frame->tile] = -1;
+    frame->tile  = -1;
+    frame->dirty = false;
+    return true;
+}
+
+// returns the least recently used frame
+static Frame *lru_frame(Paged_Grid *pg)
+{
+    Frame *frame = &pg->frames[0];
+    for(int i = 1 ; i < pg->nb_frames ; i++)
+    {
+        if(pg->frames[i].last_used < frame->last_used)
+            frame = &pg->frames[i];
+    }
+    
+    return frame;
+}
+
+// gives the memory of the least recently used frame back, writing its tile out first
+static bool drop_frame(Paged_Grid *pg)
+{
+    Frame *frame = lru_frame(pg);
+    if(!evict_frame(pg, frame))
+        return false;
+    free(frame->nodes);
+    
+    // the last frame takes its place, so the frames in use stay at the start of the array
+    Frame *last = &pg->frames[--pg->nb_frames];
+    if(frame != last)
+    {
+        *frame = *last;
+        if(frame->tile != -1)
+            pg->tile_frame[frame->tile] = frame - pg->frames;
+    }
+    
+    return true;
+}
+
+// makes room for a frontier of 'frontier_bytes' under the memory ceiling by dropping frames, down to MIN_FRAMES of them
+// Returns false if it doesn't fit even then, or if the scratch file failed
+static bool reserve_frontier(Paged_Grid *pg, size_t frontier_bytes)
+{
+    while((size_t) pg->nb_frames * pg->tile_bytes + frontier_bytes > pg->max_resident_bytes && pg->nb_frames > MIN_FRAMES)
+    {
+        if(!drop_frame(pg))
+            return false;
+    }
+    
+    if((size_t) pg->nb_frames * pg->tile_bytes + frontier_bytes > pg->max_resident_bytes)
+    {
+        fprintf(stderr, "The frontier of the search needs more memory than --out-of-core %zu allows, with %d tiles kept in memory\n",
+                pg->max_resident_bytes >> 20, pg->nb_frames);
+        return false;
+    }
+    
+    return true;
+}
+
+// returns the node at a location, paging its tile in if needed
+// the pointer is only valid until the next call, since that call may page the tile out
+// returns NULL if the scratch file can't be read or written
+static Paged_Node *paged_node(Paged_Grid *pg, Loc loc, bool write)
+{
+    const int tile = (loc.y / pg->tile_size) * pg->tiles_per_row + loc.x / pg->tile_size;
+    Frame *frame;
+    
+    if(pg->tile_frame[tile] != -1)
+    {
+        frame = &pg->frames[pg->tile_frame[tile]];
+    }
+    else
+    {
+        // page out the least recently used frame to make room for the tile
+        frame = lru_frame(pg);
+        if(!evict_frame(pg, frame))
+        {
+            return NULL;
+        }
+        
+        if(pg->tile_initialized[tile])
+        {
+            off_t offset = (off_t) tile * pg->tile_bytes;
+            if(pread(pg->fd, frame->nodes, pg->tile_bytes, offset) != (ssize_t) pg->tile_bytes)
+            {
+                fprintf(stderr, "Can't read from the scratch file: %s\n", strerror(errno));
+                return NULL;
+            }
+        }
+        else
+        {
+            // the tile was never used, so it starts with the costs at INFINITY and the parents UNKNOWN
+            const int tile_nodes = pg->tile_size * pg->tile_size;
+            for(int i = 0 ; i < tile_nodes ; i++)
+                frame->nodes[i] = (Paged_Node){.cost = INFINITY, .parent_dir = UNKNOWN};
+            frame->dirty = true;
+        }
+        
+        frame->tile = tile;
+        pg->tile_frame[tile] = frame - pg->frames;
+    }
+    
+    frame->last_used = ++pg->clock;
+    frame->dirty |= write;
+    return &frame->nodes[(loc.y % pg->tile_size) * pg->tile_size + loc.x % pg->tile_size];
+}
+
+// sets up the tiles and the frames, returns false if the scratch file can't be opened
+static bool init_paged_grid(Paged_Grid *pg, int cols, int rows, Out_Of_Core_Options options)
+{
+    const int tile_size = options.tile_size > 0 ? options.tile_size : 64;
+    const int tiles_per_row = (cols + tile_size - 1) / tile_size;
+    
+    *pg = (Paged_Grid){
+        .max_resident_bytes = options.max_resident_bytes,
+        .tile_size          = tile_size,
+        .tiles_per_row      = tiles_per_row,
+        .nb_tiles           = tiles_per_row * ((rows + tile_size - 1) / tile_size),
+        .tile_bytes         = (size_t) tile_size * tile_size * sizeof(Paged_Node),
+        .fd                 = -1
+    };
+    
+    if(options.scratch_path != NULL)
+    {
+        pg->fd = open(options.scratch_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+    else if((pg->scratch = tmpfile()) != NULL)
+    {
+        pg->fd = fileno(pg->scratch);
+    }
+    if(pg->fd == -1)
+    {
+        fprintf(stderr, "Can't open the scratch file: %s\n", strerror(errno));
+        return false;
+    }
+    
+    size_t nb_frames = options.max_resident_bytes / pg->tile_bytes;
+    if(nb_frames < MIN_FRAMES)
+        nb_frames = MIN_FRAMES;
+    if(nb_frames > (size_t) pg->nb_tiles)
+        nb_frames = pg->nb_tiles;
+    pg->nb_frames = nb_frames;
+    
+    pg->tile_frame       = (int*) malloc(pg->nb_tiles * sizeof(int));
+    pg->tile_initialized = (bool*) calloc(pg->nb_tiles, sizeof(bool));
+    pg->frames           = (Frame*) calloc(pg->nb_frames, sizeof(Frame));
+    for(int i = 0 ; i < pg->nb_tiles ; i++)
+        pg->tile_frame[i] = -1;
+    for(int i = 0 ; i < pg->nb_frames ; i++)
+    {
+        pg->frames[i].tile  = -1;
+        pg->frames[i].nodes = (Paged_Node*) malloc(pg->tile_bytes);
+    }
+    
+    return true;
+}
+
+static void free_paged_grid(Paged_Grid *pg)
+{
+    for(int i = 0 ; i < pg->nb_frames ; i++)
+        free(pg->frames[i].nodes);
+    free(pg->frames);
+    free(pg->tile_frame);
+    free(pg->tile_initialized);
+    
+    if(pg->scratch != NULL)
+        fclose(pg->scratch);
+    else if(pg->fd != -1)
+        close(pg->fd);
+}
+
+// Enqueues the adjacent nodes of the current node that are passable, unvisited and cheaper than before
+// 'start_cost' is the current cost of the start point, nodes that cost as much are not worth enqueuing
+// Returns false if the scratch file failed or the frontier outgrew the memory ceiling
+static bool expand_node(Paged_Grid *pg, Frontier *frontier, const bool *grid, int cols, int rows, Loc current, float current_cost, Loc start, float *start_cost)
+{
+    // the directions to the adjacent nodes, and the parent direction of each adjacent node (the opposite direction)
+    const Parent_Direction dirs[8]     = {UP, RIGHT, DOWN, LEFT, UP_RIGHT, DOWN_RIGHT, DOWN_LEFT, UP_LEFT};
+    const Parent_Direction opposite[8] = {DOWN, LEFT, UP, RIGHT, DOWN_LEFT, UP_LEFT, UP_RIGHT, DOWN_RIGHT};
+    const float sqrt2 = sqrtf(2);
+    
+    for(int i = 0 ; i < 8 ; i++)
+    {
+        Loc adjacent = next_loc(current, dirs[i]);
+        const float cost = current_cost + (i < 4 ? 1 : sqrt2);
+        
+        if(!in_range(adjacent, cols, rows) || !grid_get_at(grid, cols, adjacent) || cost >= *start_cost)
+            continue;
+        
+        Paged_Node *node = paged_node(pg, adjacent, false);
+        if(node == NULL)
+            return false;
+        
+        if(!node->visited && node->cost > cost)
+        {
+            // the tile is already in memory, so asking for it again only marks it dirty
+            node = paged_node(pg, adjacent, true);
+            node->cost = cost;
+            node->parent_dir = opposite[i];
+            if(!frontier_push(pg, frontier, cost, adjacent))
+                return false;
+            
+            if(locs_eq(adjacent, start))
+                *start_cost = cost;
+        }
+    }
+    
+    return true;
+}
+
+bool shortest_path_out_of_core(const bool *grid, int cols, int rows, Loc start, Loc end, Out_Of_Core_Options options, Path **path)
+{
+    *path = NULL;
+    
+    // if the start/end is not passable, there is no path
+    if(!grid_get_at(grid, cols, end) || !grid_get_at(grid, cols, start))
+    {
+        return true;
+    }
+    
+    Paged_Grid pg;
+    if(!init_paged_grid(&pg, cols, rows, options))
+    {
+        free_paged_grid(&pg);
+        return false;
+    }
+    
+    // stays false if the scratch file fails before the search is over
+    bool ok = false;
+    Frontier frontier = {0};
+    
+    // the cost from end to end is 0, and end has no NONE parent
+    Paged_Node *end_node = paged_node(&pg, end, true);
+    if(end_node == NULL)
+        goto cleanup;
+    *end_node = (Paged_Node){.cost = 0, .parent_dir = NONE};
+    if(!frontier_push(&pg, &frontier, 0, end))
+        goto cleanup;
+    
+    float start_cost = locs_eq(start, end) ? 0 : INFINITY;
+    
+    while(frontier.size != 0)
+    {
+        Frontier_Entry entry = frontier_pop(&frontier);
+        
+        Paged_Node *node = paged_node(&pg, entry.loc, false);
+        if(node == NULL)
+            goto cleanup;
+        
+        // skip the entries of nodes that were pushed again with a lower cost
+        if(node->visited || node->cost < entry.cost)
+            continue;
+        
+        node = paged_node(&pg, entry.loc, true);
+        node->visited = true;
+        
+        if(!expand_node(&pg, &frontier, grid, cols, rows, entry.loc, entry.cost, start, &start_cost))
+            goto cleanup;
+    }
+    
+    // if the start point still has UNKNOWN parent, it means no path was found
+    Paged_Node *start_node = paged_node(&pg, start, false);
+    if(start_node == NULL)
+        goto cleanup;
+    if(start_node->parent_dir == UNKNOWN)
+    {
+        ok = true;
+        goto cleanup;
+    }
+    const float cost = start_node->cost;
+    
+    // walk the path once to count its steps, and again to fill it
+    int nb_steps = 0;
+    for(Loc current = start ; !locs_eq(current, end) ; nb_steps++)
+    {
+        Paged_Node *node = paged_node(&pg, current, false);
+        if(node == NULL)
+            goto cleanup;
+        current = next_loc(current, node->parent_dir);
+    }
+    
+    Path *found = (Path*) malloc(sizeof(Path) + sizeof(Parent_Direction) * nb_steps);
+    found->cost = cost;
+    found->nb = 0;
+    for(Loc current = start ; !locs_eq(current, end) ; )
+    {
+        Paged_Node *node = paged_node(&pg, current, false);
+        if(node == NULL)
+        {
+            free(found);
+            goto cleanup;
+        }
+        found->dirs[found->nb++] = node->parent_dir;
+        current = next_loc(current, node->parent_dir);
+    }
+    *path = found;
+    ok = true;
+    
+    cleanup:
+    free(frontier.data);
+    free_paged_grid(&pg);
+    return ok;
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 #include "../include/path_finder.h"
 #include "../include/priority_queue.h"
 
@@ -54,20 +55,37 @@ Loc next_loc(Loc loc, Parent_Direction direction)
     return loc;
 }
 
+Loc grid_loc(size_t index, int cols)
+{
+#ifdef PATH_FINDER_TILED
+    const size_t tiles_per_row = tiles_round_up(cols) >> TILE_SHIFT;
+    const size_t tile    = index >> (2 * TILE_SHIFT);
+    const int    in_tile = index & ((1 << (2 * TILE_SHIFT)) - 1);
+    
+    return (Loc){
+        .x = ((tile % tiles_per_row) << TILE_SHIFT) + (in_tile & TILE_MASK),
+        .y = ((tile / tiles_per_row) << TILE_SHIFT) + (in_tile >> TILE_SHIFT)
+    };
+#else
+    return (Loc){.x = index % (size_t) cols, .y = index / (size_t) cols};
+#endif
+}
+
 // Turns a node pointer to a location in a 2D grid
 static Loc node_ptr_to_loc(Node *node, int cols, Node *grid)
 {
-    int node_index   = node - grid;
-    int node_index_x = node_index % cols;
-    int node_index_y = node_index / cols;
-    
-    return (Loc){.x = node_index_x, .y = node_index_y};
+    return grid_loc(node - grid, cols);
 }
 
-// Enqueues in the given priority queue the adjacenet nodes to the current node
+// Enqueues in the search's priority queue the adjacenet nodes to the current node
 // Ignoring unpassable nodes, nodes that were already expanded, and nodes that are too expensive
-static void enqueue_unvisited_passable_adjacents_if_cheaper(Node *current, int cols, int rows, bool *obstacle_grid, Node *node_grid, Loc start, Priority_Queue *unexpanded)
+static void enqueue_unvisited_passable_adjacents_if_cheaper(Search *search, Node *current, bool *obstacle_grid)
 {
+    const int cols = search->cols;
+    const int rows = search->rows;
+    const Loc start = search->start;
+    Node *node_grid = search->node_grid;
+    
     Loc current_loc = node_ptr_to_loc(current, cols, node_grid);
     
     Loc up         = (Loc){.x = current_loc.x,     .y = current_loc.y - 1};
@@ -115,6 +133,13 @@ static void enqueue_unvisited_passable_adjacents_if_cheaper(Node *current, int c
     const float sqrt2 = sqrtf(2);
     const float step_costs[8] = {1, 1, 1, 1, sqrt2, sqrt2, sqrt2, sqrt2};
     
+    // an array such that 'sides[i - 4]' holds the two straight directions beside the diagonal direction i
+    // used to not cut corners when the search doesn't allow it
+    const int sides[4][2] = {{0, 1}, {2, 1}, {2, 3}, {0, 3}};
+    
+    // an 8 bit number where each bit represents if the adjacent in a direction is passable
+    unsigned char passable_directions = 0;
+    
     for(int i = 0 ; i < 8 ; i++)
     {
         bool within_grid = (possible_directions & (1 << i));
@@ -122,11 +147,19 @@ static void enqueue_unvisited_passable_adjacents_if_cheaper(Node *current, int c
         {
             float step_cost = step_costs[i];
             bool passable = grid_get_at(obstacle_grid, cols, locs[i]);
+            passable_directions |= passable << i;
+            if(i >= 4 && search->no_corner_cutting)
+            {
+                passable = passable && (passable_directions & (1 << sides[i - 4][0])) && (passable_directions & (1 << sides[i - 4][1]));
+            }
             bool unvisited = !grid_get_at(node_grid, cols, locs[i]).visited;
             bool cheaper_than_old_cost = grid_get_at(node_grid, cols, locs[i]).cost > current->cost + step_cost;
             bool cheaper_than_start = grid_get_at(node_grid, cols, start).cost > current->cost + step_cost;
             if(passable && unvisited && cheaper_than_old_cost && cheaper_than_start)
             {
+                // a node that already has a cost is still in the queue with it, that entry goes stale
+                stats_add(&search->stats, decrease_keys, grid_get_at(node_grid, cols, locs[i]).cost != INFINITY);
+                
                 // set the cost as the previous node cost + step_cost
                 grid_get_at(node_grid, cols, locs[i]).cost = current->cost + step_cost;
                 // set the new parent of the enqueued node
@@ -134,64 +167,259 @@ static void enqueue_unvisited_passable_adjacents_if_cheaper(Node *current, int c
                 // set the number of steps it took to reach the node
                 grid_get_at(node_grid, cols, locs[i]).nb_steps = current->nb_steps + 1;
                 
-                enqueue(unexpanded, &grid_get_at(node_grid, cols, locs[i]));
+                stats_op_time(&search->stats, push_ns, enqueue(&search->unexpanded, &grid_get_at(node_grid, cols, locs[i])));
+                search->stats.pushes++;
+                stats_max(&search->stats, max_queue_size, (long long) search->unexpanded.size);
             }
         }
     }
 }
 
-Path *shortest_path(bool *obstacle_grid, int cols, int rows, Loc start, Loc end)
+bool find_path(Search *search, bool *obstacle_grid, int cols, int rows, Loc start, Loc end)
 {
-    // if the start/end is not passable, return NULL
-    if(!grid_get_at(obstacle_grid, cols, end) || !grid_get_at(obstacle_grid, cols, start))
+    search_begin(search, obstacle_grid, cols, rows, start, end);
+    return search_step(search, 0, 0) == SEARCH_FOUND;
+}
+
+// resets the node grid and the queue for a search of 'search', growing the node grid if it's too small
+static void reset_nodes(Search *search)
+{
+    const int cols = search->cols;
+    const int rows = search->rows;
+    const Loc end  = search->end;
+    
+    // reallocate for the node grid if it's not big enough
+    // the sizes are size_t all along, a grid file can have more cells than an int holds
+    const size_t nb_nodes = grid_size(cols, rows);
+    if(search->cap < nb_nodes)
     {
-        return NULL;
+        free(search->node_grid);
+        search->node_grid = (Node*) malloc(nb_nodes * sizeof(Node));
+        search->cap = nb_nodes;
+        if(search->node_grid == NULL)
+        {
+            fprintf(stderr, "Can't allocate the %zu nodes of a %dx%d grid\n", nb_nodes, cols, rows);
+            exit(1);
+        }
     }
+    Node *node_grid = search->node_grid;
     
-    // allocate for the node grid, setting the costs to INFINITY and the parents to UNKNOWN
-    Node *node_grid = (Node*) malloc(cols * rows * sizeof(Node));
-    for(int i = 0 ; i < cols * rows ; i++)
+    // set the costs to INFINITY and the parents to UNKNOWN
+    for(size_t i = 0 ; i < nb_nodes ; i++)
         node_grid[i] = (Node){.parent_dir = UNKNOWN, .cost = INFINITY};
     
     // the cost from end to end is 0, and end has no NONE parent
     grid_get_at(node_grid, cols, end) = (Node){.parent_dir = NONE, .cost = 0, .visited = false, .nb_steps = 0};
     
-    Priority_Queue unexpanded = init_queue(cols * rows);
+    Priority_Queue *unexpanded = &search->unexpanded;
+    init_queue(unexpanded, (size_t) cols * rows);
     
     // enqueue the end to the priority queue
-    enqueue(&unexpanded,&grid_get_at(node_grid, cols, end));
+    enqueue(unexpanded, &grid_get_at(node_grid, cols, end));
+    search->stats.pushes++;
     
-    while(unexpanded.size != 0)
+    stats_max(&search->stats, max_queue_size, (long long) unexpanded->size);
+}
+
+void search_begin(Search *search, bool *obstacle_grid, int cols, int rows, Loc start, Loc end)
+{
+    search->status = SEARCH_IN_PROGRESS;
+    search->found = false;
+    search->cost  = INFINITY;
+    search->nb    = 0;
+    search->cols  = cols;
+    search->rows  = rows;
+    search->start = start;
+    search->end   = end;
+    search->obstacle_grid = obstacle_grid;
+    search->stats = (Search_Stats){0};
+    
+    // if the start/end is not passable, no path can be found
+    if(!grid_get_at(obstacle_grid, cols, end) || !grid_get_at(obstacle_grid, cols, start))
     {
-        Node *current = dequeue(&unexpanded);
+        search->status = SEARCH_NOT_FOUND;
+        return;
+    }
+    
+    stats_time(&search->stats, reset_ns, reset_nodes(search));
+}
+
+// the number of expansions between two readings of the clock when a search has a deadline
+#define DEADLINE_CHECK_INTERVAL 32
+
+// expands nodes until the start is expanded, the queue is empty or the budget of the step is spent
+// Returns false if the budget stopped it, the search goes on from there with the next step
+static bool expand_nodes(Search *search, long long max_expansions, long long deadline_ns)
+{
+    Priority_Queue *unexpanded = &search->unexpanded;
+    Node *start_node = &grid_get_at(search->node_grid, search->cols, search->start);
+    long long expanded = 0;
+    
+    while(unexpanded->size != 0)
+    {
+        // stop once out of budget, the search goes on from here with the next step
+        if(max_expansions != 0 && expanded == max_expansions)
+        {
+            return false;
+        }
+        if(deadline_ns != 0 && expanded % DEADLINE_CHECK_INTERVAL == 0 && expanded != 0 && search_now_ns() >= deadline_ns)
+        {
+            return false;
+        }
+        
+        Node *current;
+        stats_op_time(&search->stats, pop_ns, current = dequeue(unexpanded));
+        stats_add(&search->stats, pops, 1);
+        
+        // a node is enqueued again whenever a cheaper way to it is found, only its cheapest entry is expanded
+        if(current->visited)
+            continue;
         
         current->visited = true;
-        enqueue_unvisited_passable_adjacents_if_cheaper(current, cols, rows, obstacle_grid, node_grid, start, &unexpanded);
+        expanded++;
+        search->stats.expanded++;
+        
+        // the cost of start is final once it's expanded, the nodes left in the queue can't make it cheaper
+        if(current == start_node)
+            break;
+        
+        stats_op_time(&search->stats, expand_ns, enqueue_unvisited_passable_adjacents_if_cheaper(search, current, search->obstacle_grid));
     }
     
-    // if the start point still has UNKNOWN parent, it means no path was found. Return NULL
-    if(grid_get_at(node_grid, cols, start).parent_dir == UNKNOWN)
+    return true;
+}
+
+Search_Status search_step(Search *search, long long max_expansions, long long deadline_ns)
+{
+    if(search->status != SEARCH_IN_PROGRESS)
     {
-        free(unexpanded.data);
-        free(node_grid);
-        return NULL;
+        return search->status;
     }
     
+    bool done;
+    stats_time(&search->stats, search_ns, done = expand_nodes(search, max_expansions, deadline_ns));
+    if(!done)
+    {
+        return SEARCH_IN_PROGRESS;
+    }
+    
+    Node *start_node = &grid_get_at(search->node_grid, search->cols, search->start);
+    
+    // the pushes are timed within the expansions, so their time is taken out of it
+    stats_add(&search->stats, expand_ns, -search->stats.push_ns);
+    
+    // if the start point still has UNKNOWN parent, it means no path was found
+    if(start_node->parent_dir == UNKNOWN)
+    {
+        search->status = SEARCH_NOT_FOUND;
+        return search->status;
+    }
+    
+    search->status = SEARCH_FOUND;
+    search->found = true;
+    search->cost  = start_node->cost;
+    search->nb    = start_node->nb_steps;
+    return search->status;
+}
+
+long long search_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void free_search(Search *search)
+{
+    free(search->unexpanded.data);
+    free(search->node_grid);
+    *search = (Search){0};
+}
+
+Path_Iter path_iter(const Search *search)
+{
+    return (Path_Iter){
+        .node_grid = search->node_grid,
+        .cols      = search->cols,
+        .current   = search->found ? search->start : search->end,
+        .end       = search->end
+    };
+}
+
+bool path_iter_next(Path_Iter *iter, Parent_Direction *dir)
+{
+    if(locs_eq(iter->current, iter->end))
+    {
+        return false;
+    }
+    
+    // each node points towards the end, so following the parents walks the path from start to end
+    *dir = grid_get_at(iter->node_grid, iter->cols, iter->current).parent_dir;
+    iter->current = next_loc(iter->current, *dir);
+    return true;
+}
+
+void stats_merge(Search_Stats *total, const Search_Stats *stats)
+{
+    total->expanded      += stats->expanded;
+    total->pushes        += stats->pushes;
+    total->pops          += stats->pops;
+    total->decrease_keys += stats->decrease_keys;
+    total->reset_ns      += stats->reset_ns;
+    total->search_ns     += stats->search_ns;
+    total->path_ns       += stats->path_ns;
+    total->pop_ns        += stats->pop_ns;
+    total->push_ns       += stats->push_ns;
+    total->expand_ns     += stats->expand_ns;
+    if(stats->max_queue_size > total->max_queue_size)
+        total->max_queue_size = stats->max_queue_size;
+}
+
+#ifdef PATH_FINDER_STATS_TIME
+long long stats_now_ns()
+{
+    return search_now_ns();
+}
+#endif
+
+Path *shortest_path(bool *obstacle_grid, int cols, int rows, Loc start, Loc end)
+{
+    return shortest_path_with_stats(obstacle_grid, cols, rows, start, end, NULL);
+}
+
+// returns the path of a search that found it
+static Path *make_path(const Search *search)
+{
     // allocate for a path, which is just a cost with an array of directions
-    Path *path = (Path*) malloc(sizeof(Path) + (sizeof(Parent_Direction) * grid_get_at(node_grid, cols, start).nb_steps));
+    Path *path = (Path*) malloc(sizeof(Path) + (sizeof(Parent_Direction) * search->nb));
     path->nb = 0;
-    path->cost = grid_get_at(node_grid, cols, start).cost;
+    path->cost = search->cost;
     
     // fill the path with the directions from start to end
-    Loc current = start;
-    while(!locs_eq(current, end))
+    Path_Iter iter = path_iter(search);
+    Parent_Direction dir;
+    while(path_iter_next(&iter, &dir))
     {
-        path->dirs[path->nb++] = grid_get_at(node_grid, cols, current).parent_dir;
-        current = next_loc(current, grid_get_at(node_grid, cols, current).parent_dir);
+        path->dirs[path->nb++] = dir;
     }
     
+    return path;
+}
+
+Path *shortest_path_with_stats(bool *obstacle_grid, int cols, int rows, Loc start, Loc end, Search_Stats *stats)
+{
+    Search search = {0};
+    bool found = find_path(&search, obstacle_grid, cols, rows, start, end);
+    
+    // if no path was found, return NULL
+    Path *path = NULL;
+    if(found)
+        stats_time(&search.stats, path_ns, path = make_path(&search));
+    
+    if(stats != NULL)
+        *stats = search.stats;
+    
     // cleanup
-    free(unexpanded.data);
-    free(node_grid);
+    free_search(&search);
     return path;
 }
@@ -1,4 +1,6 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include "../include/path_finder.h"
 #include "../include/priority_queue.h"
 
 #define parent(n) ((n-1)/2)
@@ -6,13 +8,25 @@
 #define right(n)  (2*n + 2)
 #define root      (0)
 
-Priority_Queue init_queue(int cap)
+// grows the queue to hold 'cap' nodes, exiting if it can't
+static void grow_queue(Priority_Queue *q, size_t cap)
 {
-    Priority_Queue ret = {
-        .data = (Node**) calloc(cap, sizeof(Node*))
-    };
+    Node **data = (Node**) realloc(q->data, cap * sizeof(Node*));
+    if(data == NULL)
+    {
+        fprintf(stderr, "Can't allocate a queue of %zu nodes\n", cap);
+        exit(1);
+    }
     
-    return ret;
+    q->data = data;
+    q->cap = cap;
+}
+
+void init_queue(Priority_Queue *q, size_t cap)
+{
+    if(cap > q->cap)
+        grow_queue(q, cap);
+    q->size = 0;
 }
 
 static void swap_nodes(Node **a, Node **b)
@@ -25,7 +39,7 @@ static void swap_nodes(Node **a, Node **b)
 // swaps the rightmost node with its parent iteratively until data structure is a proper min-heap
 static void sift_up(Priority_Queue *q)
 {
-    int current = q->size - 1;
+    size_t current = q->size - 1;
     
     while(current != 0 && q->data[current]->cost < q->data[parent(current)]->cost)
     {
@@ -36,7 +50,7 @@ static void sift_up(Priority_Queue *q)
 
 // compares parent with children
 // returns the index of the smallest
-static int min_of_family(Node **arr, int size, int parent)
+static size_t min_of_family(Node **arr, size_t size, size_t parent)
 {
     // parent has no children
     if(left(parent) >= size) 
@@ -66,9 +80,9 @@ static int min_of_family(Node **arr, int size, int parent)
 // swaps parent with least of children iteratively until the data structure is a proper min-heap
 static void sift_down(Priority_Queue *q)
 {
-    int parent = root;
-    int old_parent;
-    int least;
+    size_t parent = root;
+    size_t old_parent;
+    size_t least;
     
     do
     {
@@ -81,6 +95,10 @@ static void sift_down(Priority_Queue *q)
 
 void enqueue(Priority_Queue *q, Node *n)
 {
+    // a node can be enqueued more than once, so the queue may outgrow its initial capacity
+    if(q->size == q->cap)
+        grow_queue(q, q->cap ? q->cap * 2 : 16);
+    
     q->data[q->size] = n;
     q->size++;
     sift_up(q);
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/render.h"
+#include "../include/out_buf.h"
+
+// A cell of the path, with the direction it points to (its parent)
+typedef struct Path_Cell {
+    Loc loc;
+    Parent_Direction dir;
+} Path_Cell;
+
+// compares path cells by row, then by col, for qsort
+static int compare_path_cells(const void *a, const void *b)
+{
+    const Loc l = ((const Path_Cell*) a)->loc;
+    const Loc r = ((const Path_Cell*) b)->loc;
+    if(l.y != r.y)
+        return (l.y > r.y) - (l.y < r.y);
+    return (l.x > r.x) - (l.x < r.x);
+}
+
+// Appends a cell followed by the '|' to the right of it
+static void write_cell(Out_Buf *out, const char *glyph)
+{
+    out_puts(out, glyph);
+    out_write(out, "|", 1);
+}
+
+Window path_window(Path *path, Loc start, int margin, int cols, int rows)
+{
+    Window window = {.min = start, .max = start};
+    
+    // grow the window to fit every cell of the path
+    Loc current = start;
+    for(int i = 0 ; path != NULL && i < path->nb ; i++)
+    {
+        current = next_loc(current, path->dirs[i]);
+        if(current.x < window.min.x) window.min.x = current.x;
+        if(current.y < window.min.y) window.min.y = current.y;
+        if(current.x > window.max.x) window.max.x = current.x;
+        if(current.y > window.max.y) window.max.y = current.y;
+    }
+    
+    // add the margin, without going outside the grid
+    window.min.x = window.min.x - margin < 0 ? 0 : window.min.x - margin;
+    window.min.y = window.min.y - margin < 0 ? 0 : window.min.y - margin;
+    window.max.x = window.max.x + margin >= cols ? cols - 1 : window.max.x + margin;
+    window.max.y = window.max.y + margin >= rows ? rows - 1 : window.max.y + margin;
+    
+    return window;
+}
+
+// returns true if a location is within a window
+static bool in_window(Loc loc, Window window)
+{
+    return loc.x >= window.min.x && loc.x <= window.max.x && loc.y >= window.min.y && loc.y <= window.max.y;
+}
+
+void print_path(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows)
+{
+    print_path_window(path, start, end, obstacles, cols, (Window){.min = {0, 0}, .max = {cols - 1, rows - 1}});
+}
+
+void print_path_window(Path *path, Loc start, Loc end, const bool *obstacles, int cols, Window window)
+{
+    if(path == NULL)
+    {
+        puts("\nno path found");
+        return;
+    }
+    
+    // the UTF-8 bytes of every glyph, so nothing has to be converted while printing
+    // this array is used to go from bool to cell, such that:
+    // obstacles_glyphs[false] = "🞨"
+    // obstacles_glyphs[true]  = " "
+    const char *obstacles_glyphs[2] = {u8"🞨", " "};
+    
+    // indexed by direction, an arrow pointing to the parent of the cell
+    const char *arrows[10] = {
+        [UP]   = u8"🡑", [UP_RIGHT]   = u8"🡕", [RIGHT] = u8"🡒", [DOWN_RIGHT] = u8"🡖",
+        [DOWN] = u8"🡓", [DOWN_LEFT]  = u8"🡗", [LEFT]  = u8"🡐", [UP_LEFT]    = u8"🡔"
+    };
+    
+    // the cells of the path within the window sorted by row, so they can be drawn while the rows are written in order
+    // the first direction (start to second cell) isn't drawn, as 'S' is already there, and the end is 'E'
+    int nb_cells = 0;
+    Path_Cell *cells = (Path_Cell*) malloc((path->nb > 1 ? path->nb - 1 : 1) * sizeof(Path_Cell));
+    Loc current = path->nb > 0 ? next_loc(start, path->dirs[0]) : start;
+    for(int i = 1 ; i < path->nb ; i++)
+    {
+        if(path->dirs[i] < UP || path->dirs[i] > UP_LEFT)
+        {
+            fprintf(stderr, "Unexpected direction of value '%d'\n", path->dirs[i]);
+            exit(1);
+        }
+        
+        if(in_window(current, window))
+            cells[nb_cells++] = (Path_Cell){.loc = current, .dir = path->dirs[i]};
+        current = next_loc(current, path->dirs[i]);
+    }
+    qsort(cells, nb_cells, sizeof(Path_Cell), compare_path_cells);
+    
+    printf("\ncost: %.2f\n\n", path->cost);
+    fflush(stdout);
+    
+    static Out_Buf out;
+    out.f = stdout;
+    out.len = 0;
+    
+    int next_cell = 0;
+    for(int i = window.min.y ; i <= window.max.y ; i++)
+    {
+        // the leftmost '|' of each line
+        out_write(&out, "|", 1);
+        
+        for(int j = window.min.x ; j <= window.max.x ; j++)
+        {
+            const Loc loc = {j, i};
+            
+            if(locs_eq(loc, start))
+                write_cell(&out, "S");
+            else if(locs_eq(loc, end))
+                write_cell(&out, "E");
+            else if(next_cell < nb_cells && locs_eq(loc, cells[next_cell].loc))
+                write_cell(&out, arrows[cells[next_cell].dir]);
+            else
+                write_cell(&out, obstacles_glyphs[grid_get_at(obstacles, cols, loc)]);
+            
+            // skip the path cell that was just drawn
+            while(next_cell < nb_cells && compare_path_cells(&cells[next_cell], &(Path_Cell){.loc = loc}) <= 0)
+                next_cell++;
+        }
+        
+        // a newline to end the row
+        out_write(&out, "\n", 1);
+    }
+    
+    out_write(&out, "\n", 1);
+    out_flush(&out);
+    fflush(stdout);
+    
+    // cleanup
+    free(cells);
+}
+
+void print_overview(Path *path, Loc start, Loc end, const bool *obstacles, int cols, int rows, int width)
+{
+    if(path == NULL)
+    {
+        puts("\nno path found");
+        return;
+    }
+    
+    // each character summarizes a square block of cells, as big as needed to fit 'width' characters in a row
+    const int block    = (cols + width - 1) / width;
+    const int out_cols = (cols + block - 1) / block;
+    const int out_rows = (rows + block - 1) / block;
+    
+    // the glyphs for the share of unpassable cells in a block, from none to all of them
+    const char *density_glyphs[5] = {" ", u8"░", u8"▒", u8"▓", u8"█"};
+    
+    // marks the blocks the path goes through, the path is walked once instead of looking for it in every block
+    enum { NO_PATH = 0, ON_PATH, START_BLOCK, END_BLOCK };
+    unsigned char *marks = (unsigned char*) calloc((size_t) out_cols * out_rows, 1);
+    Loc current = start;
+    for(int i = 0 ; i < path->nb ; i++)
+    {
+        current = next_loc(current, path->dirs[i]);
+        marks[(size_t) (current.y / block) * out_cols + current.x / block] = ON_PATH;
+    }
+    marks[(size_t) (start.y / block) * out_cols + start.x / block] = START_BLOCK;
+    marks[(size_t) (end.y / block) * out_cols + end.x / block]     = END_BLOCK;
+    
+    printf("\ncost: %.2f\n\noverview, each character is %dx%d cells:\n\n", path->cost, block, block);
+    fflush(stdout);
+    
+    static Out_Buf out;
+    out.f = stdout;
+    out.len = 0;
+    
+    // at most 4x4 cells of a block are sampled, so the time taken depends on the size of the overview, not of the grid
+    const int samples = block < 4 ? block : 4;
+    
+    for(int i = 0 ; i < out_rows ; i++)
+    {
+        for(int j = 0 ; j < out_cols ; j++)
+        {
+            switch(marks[(size_t) i * out_cols + j])
+            {
+                case START_BLOCK:
+                    out_write(&out, "S", 1);
+                    continue;
+                case END_BLOCK:
+                    out_write(&out, "E", 1);
+                    continue;
+                case ON_PATH:
+                    out_write(&out, "*", 1);
+                    continue;
+            }
+            
+            // sample the cells at the centers of an even 'samples' x 'samples' split of the block
+            int sampled = 0;
+            int unpassable = 0;
+            for(int si = 0 ; si < samples ; si++)
+            {
+                const int y = i * block + (2 * si + 1) * block / (2 * samples);
+                if(y >= rows)
+                    break;
+                for(int sj = 0 ; sj < samples ; sj++)
+                {
+                    const int x = j * block + (2 * sj + 1) * block / (2 * samples);
+                    if(x >= cols)
+                        break;
+                    sampled++;
+                    unpassable += !grid_get_at(obstacles, cols, ((Loc){x, y}));
+                }
+            }
+            
+            // all passable and all unpassable get their own glyph, everything in between is split in 3
+            const int density = unpassable == 0 ? 0 : (unpassable == sampled ? 4 : 1 + (3 * unpassable - 1) / sampled);
+            out_puts(&out, density_glyphs[density]);
+        }
+        
+        out_write(&out, "\n", 1);
+    }
+    
+    out_write(&out, "\n", 1);
+    out_flush(&out);
+    fflush(stdout);
+    
+    free(marks);
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/result.h"
+
+char dir_to_char(Parent_Direction dir)
+{
+    // indexed by the direction, NONE and UNKNOWN never appear in a path
+    const char chars[10] = {'?', '?', '8', '6', '2', '4', '9', '3', '1', '7'};
+    return chars[dir];
+}
+
+bool parse_output_format(const char *name, Output_Format *format)
+{
+    const char *names[3] = {"text", "json", "binary"};
+    for(int i = 0 ; i < 3 ; i++)
+    {
+        if(strcmp(name, names[i]) == 0)
+        {
+            *format = (Output_Format) i;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+// appends the path as one character per direction
+static void write_dir_chars(Out_Buf *out, int nb, const Parent_Direction *dirs)
+{
+    char chunk[256];
+    for(int i = 0 ; i < nb ; i += sizeof(chunk))
+    {
+        int n = nb - i < (int) sizeof(chunk) ? nb - i : (int) sizeof(chunk);
+        for(int j = 0 ; j < n ; j++)
+            chunk[j] = dir_to_char(dirs[i + j]);
+        out_write(out, chunk, n);
+    }
+}
+
+void write_result(Out_Buf *out, Output_Format format, bool found, float cost, int nb, const Parent_Direction *dirs)
+{
+    if(!found)
+    {
+        nb = 0;
+        dirs = NULL;
+    }
+    
+    char line[64];
+    switch(format)
+    {
+        case FORMAT_TEXT:
+            if(!found)
+            {
+                out_puts(out, "-1 0\n");
+                return;
+            }
+            out_write(out, line, snprintf(line, sizeof(line), "%.2f %d", cost, nb));
+            if(dirs != NULL && nb > 0)
+            {
+                out_write(out, " ", 1);
+                write_dir_chars(out, nb, dirs);
+            }
+            out_write(out, "\n", 1);
+            break;
+            
+        case FORMAT_JSON:
+            if(!found)
+            {
+                out_puts(out, "{\"cost\":null,\"steps\":0}\n");
+                return;
+            }
+            out_write(out, line, snprintf(line, sizeof(line), "{\"cost\":%.9g,\"steps\":%d", cost, nb));
+            if(dirs != NULL)
+            {
+                out_puts(out, ",\"path\":\"");
+                write_dir_chars(out, nb, dirs);
+                out_write(out, "\"", 1);
+            }
+            out_puts(out, "}\n");
+            break;
+            
+        case FORMAT_BINARY:
+        {
+            Result_Record record = {
+                .cost  = found ? cost : -1,
+                .steps = nb,
+                .packed_len = dirs != NULL ? (nb + 1) / 2 : 0
+            };
+            out_write(out, &record, sizeof(record));
+            
+            // two directions per byte, they all fit in 4 bits
+            unsigned char chunk[256];
+            for(int i = 0 ; i < (int) record.packed_len ; i += sizeof(chunk))
+            {
+                int n = (int) record.packed_len - i < (int) sizeof(chunk) ? (int) record.packed_len - i : (int) sizeof(chunk);
+                for(int j = 0 ; j < n ; j++)
+                {
+                    const int k = 2 * (i + j);
+                    chunk[j] = dirs[k] | (k + 1 < nb ? dirs[k + 1] << 4 : 0);
+                }
+                out_write(out, chunk, n);
+            }
+            break;
+        }
+    }
+}
+
+void print_stats(FILE *f, const Search_Stats *stats, long long nb_searches)
+{
+    // the expansions and pushes are counted by every build
+    const double n = nb_searches > 0 ? nb_searches : 1;
+    fprintf(f, "nodes expanded: %lld (%.1f per search)\n", stats->expanded, stats->expanded / n);
+#ifdef PATH_FINDER_STATS
+    fprintf(f, "queue pushes: %lld (%.1f per search), pops: %lld (%.1f per search)\n", stats->pushes, stats->pushes / n, stats->pops, stats->pops / n);
+    fprintf(f, "decrease-keys (stale entries): %lld (%.1f per search)\n", stats->decrease_keys, stats->decrease_keys / n);
+    fprintf(f, "max queue size: %lld\n", stats->max_queue_size);
+#ifdef PATH_FINDER_STATS_TIME
+    fprintf(f, "time (ms): reset %.3f, search %.3f, path %.3f\n", stats->reset_ns / 1e6, stats->search_ns / 1e6, stats->path_ns / 1e6);
+#else
+    fprintf(f, "times aren't measured, build with 'make stats' to measure them\n");
+#endif
+#ifdef PATH_FINDER_STATS_OP_TIME
+    fprintf(f, "time in the search (ms): expansion %.3f, queue pushes %.3f, queue pops %.3f\n", stats->expand_ns / 1e6, stats->push_ns / 1e6, stats->pop_ns / 1e6);
+#endif
+#else
+    fprintf(f, "queue pushes: %lld (%.1f per search)\n", stats->pushes, stats->pushes / n);
+    fprintf(f, "the other search stats aren't counted, build with 'make stats' to count them\n");
+#endif
+}
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include "../include/scheduler.h"
+
+void scheduler_add(Scheduler *scheduler, Search *search)
+{
+    if(scheduler->nb == scheduler->cap)
+    {
+        scheduler->cap = scheduler->cap ? scheduler->cap * 2 : 16;
+        scheduler->searches = (Search**) realloc(scheduler->searches, scheduler->cap * sizeof(Search*));
+    }
+    
+    // added just before the one that runs first, so it runs last on the next tick
+    for(int i = scheduler->nb ; i > scheduler->first ; i--)
+        scheduler->searches[i] = scheduler->searches[i - 1];
+    scheduler->searches[scheduler->first] = search;
+    scheduler->nb++;
+    scheduler->first = (scheduler->first + 1) % scheduler->nb;
+}
+
+// removes the searches that are done, keeping the order of the others
+static void remove_done(Scheduler *scheduler)
+{
+    int kept = 0;
+    int first = 0;
+    for(int i = 0 ; i < scheduler->nb ; i++)
+    {
+        // the one that runs first stays the first of the ones kept after it
+        if(i == scheduler->first)
+            first = kept;
+        if(scheduler->searches[i]->status == SEARCH_IN_PROGRESS)
+            scheduler->searches[kept++] = scheduler->searches[i];
+    }
+    
+    scheduler->nb = kept;
+    scheduler->first = first < kept ? first : 0;
+}
+
+void scheduler_remove(Scheduler *scheduler, Search *search)
+{
+    for(int i = 0 ; i < scheduler->nb ; i++)
+    {
+        if(scheduler->searches[i] != search)
+            continue;
+        
+        for(int j = i ; j < scheduler->nb - 1 ; j++)
+            scheduler->searches[j] = scheduler->searches[j + 1];
+        scheduler->nb--;
+        
+        if(i < scheduler->first)
+            scheduler->first--;
+        if(scheduler->first >= scheduler->nb)
+            scheduler->first = 0;
+        return;
+    }
+}
+
+int scheduler_tick(Scheduler *scheduler, long long budget_ns)
+{
+    const int nb = scheduler->nb;
+    if(nb == 0)
+        return 0;
+    
+    const long long deadline = search_now_ns() + budget_ns;
+    
+    // each search runs at most once per tick, until the budget is spent
+    int ran = 0;
+    while(ran < nb)
+    {
+        const long long now = search_now_ns();
+        if(now >= deadline)
+            break;
+        
+        // an equal share of the time left between this search and the ones after it
+        const long long share = (deadline - now) / (nb - ran);
+        search_step(scheduler->searches[(scheduler->first + ran) % nb], 0, now + share);
+        ran++;
+    }
+    
+    // the next tick starts with the first search that didn't run, or the one after this tick's first if they all did
+    scheduler->first = (scheduler->first + (ran < nb ? ran : 1)) % nb;
+    
+    remove_done(scheduler);
+    return scheduler->nb;
+}
+
+void free_scheduler(Scheduler *scheduler)
+{
+    free(scheduler->searches);
+    *scheduler = (Scheduler){0};
+}
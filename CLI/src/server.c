@@ -0,0 +1,612 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../include/server.h"
+#include "../include/batch.h"
+#include "../include/result.h"
+
+// the number of queries waiting for a worker, readers wait when it's reached
+#define JOB_QUEUE_CAP 4096
+
+// the bytes of answers a connection keeps unsent before its reader stops reading requests
+#define ANSWERS_MAX_SIZE (1 << 24)
+
+// A growable buffer of answers
+typedef struct Answer_Buf {
+    char *data;
+    size_t len;
+    size_t cap;
+} Answer_Buf;
+
+// A client connection, shared by its reader thread, its sender thread and the workers answering its requests
+// workers only copy their answers to 'filling', the sender writes them to the socket without holding the lock,
+// so a client that's slow to read its answers only stalls its own connection
+typedef struct Connection {
+    int fd;                         // a copy of the socket, only written by the sender
+    pthread_mutex_t write_lock;     // guards 'filling', 'pending' and 'reading_done'
+    pthread_cond_t answers_ready;   // signaled when the sender has something to do
+    pthread_cond_t answers_sent;    // signaled when the sender emptied 'filling'
+    Answer_Buf filling;             // answers waiting for the sender
+    Answer_Buf sending;             // answers being written by the sender
+    int pending;                    // requests read but not answered yet
+    bool reading_done;              // set when the client closed its side
+    int refs;                       // the reader, the sender and every pending request hold one, freed at 0
+} Connection;
+
+// A query waiting for a worker
+typedef struct Job {
+    Connection *conn;
+    uint32_t id;
+    Query_Request query;
+} Job;
+
+// A bounded queue of jobs, shared by all the connections
+typedef struct Job_Queue {
+    Job jobs[JOB_QUEUE_CAP];
+    int head;
+    int size;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} Job_Queue;
+
+// A version of the grid, never changed once published
+// queries read the current snapshot while a delta builds the next one on a copy
+typedef struct Snapshot {
+    bool *grid;
+    bool owned;            // false for the first snapshot, which is the loaded map
+    uint64_t version;
+    uint64_t retired_at;   // the epoch it was replaced in
+    struct Snapshot *next; // in the list of replaced snapshots
+} Snapshot;
+
+// A delta waiting for the writer
+typedef struct Delta {
+    Connection *conn;
+    uint32_t id;
+    uint32_t nb;
+    bool refused; // set if a cell is outside the map
+    struct Delta *next;
+    Cell_Update cells[];
+} Delta;
+
+// The epoch a worker announced before reading the current snapshot, 0 when it's not reading one
+// each one is on its own cache line, since its worker writes it for every query
+typedef struct Worker_Epoch {
+    uint64_t epoch;
+    char padding[64 - sizeof(uint64_t)];
+} Worker_Epoch;
+
+// The state shared by all the threads of the server
+typedef struct Server {
+    Map map;
+    Job_Queue queue;
+    
+    // the grid queries read, replaced as a whole by the writer
+    Snapshot *current;
+    
+    // a replaced snapshot is freed once no worker announced an epoch before or at the one it was replaced in
+    uint64_t epoch;
+    Worker_Epoch *worker_epochs;
+    int nb_workers;
+    
+    // the deltas waiting for the writer, which applies all of them to a single copy
+    Delta *deltas;
+    pthread_mutex_t deltas_lock;
+    pthread_cond_t deltas_ready;
+} Server;
+
+// the argument of a worker thread
+typedef struct Worker_Arg {
+    Server *server;
+    int index;
+} Worker_Arg;
+
+// the argument of a connection's reader thread
+typedef struct Reader_Arg {
+    Server *server;
+    int fd;
+} Reader_Arg;
+
+static void push_job(Job_Queue *q, Job job)
+{
+    pthread_mutex_lock(&q->lock);
+    while(q->size == JOB_QUEUE_CAP)
+        pthread_cond_wait(&q->not_full, &q->lock);
+    
+    q->jobs[(q->head + q->size) % JOB_QUEUE_CAP] = job;
+    q->size++;
+    
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static Job pop_job(Job_Queue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    while(q->size == 0)
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    
+    Job job = q->jobs[q->head];
+    q->head = (q->head + 1) % JOB_QUEUE_CAP;
+    q->size--;
+    
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+// drops a reference to the connection, closing it with the last one
+static void release_connection(Connection *conn)
+{
+    if(__atomic_sub_fetch(&conn->refs, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+    
+    close(conn->fd);
+    pthread_mutex_destroy(&conn->write_lock);
+    pthread_cond_destroy(&conn->answers_ready);
+    pthread_cond_destroy(&conn->answers_sent);
+    free(conn->filling.data);
+    free(conn->sending.data);
+    free(conn);
+}
+
+// counts a request of the connection as pending until it's answered
+// waits first while too many answers of the connection are unsent, so a client that doesn't read them can't grow them forever
+static void hold_connection(Connection *conn)
+{
+    pthread_mutex_lock(&conn->write_lock);
+    while(conn->filling.len >= ANSWERS_MAX_SIZE)
+        pthread_cond_wait(&conn->answers_sent, &conn->write_lock);
+    conn->pending++;
+    pthread_mutex_unlock(&conn->write_lock);
+    __atomic_add_fetch(&conn->refs, 1, __ATOMIC_RELAXED);
+}
+
+static void append_answer(Answer_Buf *buf, const void *data, size_t len)
+{
+    if(buf->len + len > buf->cap)
+    {
+        buf->cap = (buf->len + len) * 2;
+        buf->data = (char*) realloc(buf->data, buf->cap);
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+// queues the answer of a pending request for the connection's sender, and drops the request's reference to the connection
+static void send_answer(Connection *conn, Response_Header header, const void *body, size_t len)
+{
+    pthread_mutex_lock(&conn->write_lock);
+    append_answer(&conn->filling, &header, sizeof(header));
+    append_answer(&conn->filling, body, len);
+    
+    // pipelined answers are sent together, once the last pending one is queued or there are enough of them
+    if(--conn->pending == 0 || conn->filling.len >= OUT_BUF_SIZE)
+        pthread_cond_signal(&conn->answers_ready);
+    
+    pthread_mutex_unlock(&conn->write_lock);
+    release_connection(conn);
+}
+
+// writes the answers of a connection to its socket, until the client closed it and every request is answered
+static void *send_answers(void *arg)
+{
+    Connection *conn = (Connection*) arg;
+    bool broken = false;
+    
+    pthread_mutex_lock(&conn->write_lock);
+    while(1)
+    {
+        while(!(conn->filling.len > 0 && (conn->pending == 0 || conn->filling.len >= OUT_BUF_SIZE))
+              && !(conn->reading_done && conn->pending == 0 && conn->filling.len == 0))
+            pthread_cond_wait(&conn->answers_ready, &conn->write_lock);
+        
+        if(conn->filling.len == 0)
+            break;
+        
+        // the workers fill the other buffer while this one is written
+        Answer_Buf sent = conn->filling;
+        conn->filling = conn->sending;
+        conn->sending = sent;
+        pthread_cond_broadcast(&conn->answers_sent);
+        pthread_mutex_unlock(&conn->write_lock);
+        
+        // once the client is gone its answers are dropped
+        for(size_t done = 0 ; done < sent.len && !broken ; )
+        {
+            ssize_t n = write(conn->fd, sent.data + done, sent.len - done);
+            if(n > 0)
+                done += n;
+            else if(n == 0 || errno != EINTR)
+                broken = true;
+        }
+        
+        pthread_mutex_lock(&conn->write_lock);
+        conn->sending.len = 0;
+    }
+    pthread_mutex_unlock(&conn->write_lock);
+    
+    release_connection(conn);
+    return NULL;
+}
+
+static void push_delta(Server *server, Delta *delta)
+{
+    pthread_mutex_lock(&server->deltas_lock);
+    delta->next = server->deltas;
+    server->deltas = delta;
+    pthread_cond_signal(&server->deltas_ready);
+    pthread_mutex_unlock(&server->deltas_lock);
+}
+
+// reads the requests of a connection and queues its queries and deltas, until the client closes it
+static void *read_requests(void *arg)
+{
+    Server *server = ((Reader_Arg*) arg)->server;
+    const int fd = ((Reader_Arg*) arg)->fd;
+    free(arg);
+    
+    // the answers are written by the sender to a copy of the socket, so the reader can close its stream
+    Connection *conn = (Connection*) calloc(1, sizeof(Connection));
+    conn->fd   = dup(fd);
+    conn->refs = 2;
+    pthread_mutex_init(&conn->write_lock, NULL);
+    pthread_cond_init(&conn->answers_ready, NULL);
+    pthread_cond_init(&conn->answers_sent, NULL);
+    FILE *in = fdopen(fd, "r");
+    
+    pthread_t sender;
+    pthread_create(&sender, NULL, send_answers, conn);
+    pthread_detach(sender);
+    
+    Request_Header header;
+    while(fread(&header, sizeof(header), 1, in) == 1)
+    {
+        if(header.type == MESSAGE_QUERY)
+        {
+            Job job = {.conn = conn, .id = header.id};
+            if(fread(&job.query, sizeof(job.query), 1, in) != 1)
+                break;
+            
+            hold_connection(conn);
+            push_job(&server->queue, job);
+        }
+        else if(header.type == MESSAGE_DELTA)
+        {
+            Delta_Request request;
+            if(fread(&request, sizeof(request), 1, in) != 1)
+                break;
+            if(request.nb > DELTA_MAX_CELLS)
+            {
+                fprintf(stderr, "A delta of %u cells is more than the %d allowed, closing the connection\n", request.nb, DELTA_MAX_CELLS);
+                break;
+            }
+            
+            Delta *delta = (Delta*) malloc(sizeof(Delta) + request.nb * sizeof(Cell_Update));
+            delta->conn = conn;
+            delta->id = header.id;
+            delta->nb = request.nb;
+            delta->refused = false;
+            if(fread(delta->cells, sizeof(Cell_Update), request.nb, in) != request.nb)
+            {
+                free(delta);
+                break;
+            }
+            
+            hold_connection(conn);
+            push_delta(server, delta);
+        }
+        else
+        {
+            // the size of an unknown message isn't known, so the rest of the stream can't be read
+            fprintf(stderr, "Unknown message type %u, closing the connection\n", header.type);
+            break;
+        }
+    }
+    
+    fclose(in);
+    
+    // the sender stops once the answers of the requests read are sent
+    pthread_mutex_lock(&conn->write_lock);
+    conn->reading_done = true;
+    pthread_cond_signal(&conn->answers_ready);
+    pthread_mutex_unlock(&conn->write_lock);
+    
+    release_connection(conn);
+    return NULL;
+}
+
+// answers queued queries, with a search that's reused by all of them
+static void *answer_queries(void *arg)
+{
+    Server *server = ((Worker_Arg*) arg)->server;
+    uint64_t *announced = &server->worker_epochs[((Worker_Arg*) arg)->index].epoch;
+    const int cols = server->map.cols;
+    const int rows = server->map.rows;
+    free(arg);
+    
+    Search search = {0};
+    Parent_Direction *dirs = NULL;
+    int dirs_cap = 0;
+    
+    // every answer is formatted in memory first, to be handed to the connection's sender at once
+    char *answer = NULL;
+    size_t answer_size = 0;
+    Out_Buf *out = (Out_Buf*) malloc(sizeof(Out_Buf));
+    out->f = open_memstream(&answer, &answer_size);
+    out->len = 0;
+    
+    while(1)
+    {
+        Job job = pop_job(&server->queue);
+        const Query_Request *query = &job.query;
+        const Loc start = {query->start_x, query->start_y};
+        const Loc end   = {query->end_x, query->end_y};
+        const bool encode = query->flags & QUERY_ENCODE;
+        
+        Response_Header header = {.id = job.id, .status = STATUS_OK};
+        if(!in_range(start, cols, rows) || !in_range(end, cols, rows))
+        {
+            header.status = STATUS_BAD_REQUEST;
+        }
+        else
+        {
+            // the snapshot read after announcing the epoch isn't freed until the epoch is cleared
+            __atomic_store_n(announced, __atomic_load_n(&server->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+            Snapshot *snapshot = __atomic_load_n(&server->current, __ATOMIC_SEQ_CST);
+            
+            find_path(&search, snapshot->grid, cols, rows, start, end);
+            
+            __atomic_store_n(announced, 0, __ATOMIC_RELEASE);
+            
+            if(encode && search.found)
+            {
+                // the empty path of a query from a cell to itself still needs a buffer, or it would be left out of the result
+                if(search.nb > dirs_cap || dirs == NULL)
+                {
+                    dirs_cap = search.nb * 2 + 1;
+                    dirs = (Parent_Direction*) realloc(dirs, dirs_cap * sizeof(Parent_Direction));
+                }
+                
+                Path_Iter iter = path_iter(&search);
+                for(int i = 0 ; path_iter_next(&iter, &dirs[i]) ; i++);
+            }
+        }
+        
+        // the size of a memory stream is its position, so rewinding it reuses its memory for the next answer
+        fseek(out->f, 0, SEEK_SET);
+        if(header.status == STATUS_OK)
+        {
+            write_result(out, FORMAT_BINARY, search.found, search.cost, search.nb, encode ? dirs : NULL);
+            out_flush(out);
+        }
+        fflush(out->f);
+        send_answer(job.conn, header, answer, answer_size);
+    }
+    
+    return NULL;
+}
+
+// frees the replaced snapshots no worker can still be reading
+static void reclaim_snapshots(Server *server, Snapshot **retired)
+{
+    uint64_t oldest = UINT64_MAX;
+    for(int i = 0 ; i < server->nb_workers ; i++)
+    {
+        uint64_t epoch = __atomic_load_n(&server->worker_epochs[i].epoch, __ATOMIC_SEQ_CST);
+        if(epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+    
+    // a worker that announced an epoch after the one a snapshot was replaced in reads a newer snapshot
+    for(Snapshot **s = retired ; *s != NULL ; )
+    {
+        if((*s)->retired_at < oldest)
+        {
+            Snapshot *freed = *s;
+            *s = freed->next;
+            free(freed->grid);
+            free(freed);
+        }
+        else
+        {
+            s = &(*s)->next;
+        }
+    }
+}
+
+// applies the deltas, all the ones waiting at once on a copy of the current grid
+static void *apply_deltas(void *arg)
+{
+    Server *server = (Server*) arg;
+    const int cols = server->map.cols;
+    const int rows = server->map.rows;
+    Snapshot *retired = NULL;
+    
+    while(1)
+    {
+        pthread_mutex_lock(&server->deltas_lock);
+        while(server->deltas == NULL)
+        {
+            // snapshots still read by a worker are checked again a bit later
+            if(retired == NULL)
+            {
+                pthread_cond_wait(&server->deltas_ready, &server->deltas_lock);
+            }
+            else
+            {
+                struct timespec wake;
+                clock_gettime(CLOCK_REALTIME, &wake);
+                wake.tv_nsec += 10 * 1000 * 1000;
+                if(wake.tv_nsec >= 1000 * 1000 * 1000)
+                {
+                    wake.tv_sec++;
+                    wake.tv_nsec -= 1000 * 1000 * 1000;
+                }
+                pthread_cond_timedwait(&server->deltas_ready, &server->deltas_lock, &wake);
+                
+                pthread_mutex_unlock(&server->deltas_lock);
+                reclaim_snapshots(server, &retired);
+                pthread_mutex_lock(&server->deltas_lock);
+            }
+        }
+        Delta *deltas = server->deltas;
+        server->deltas = NULL;
+        pthread_mutex_unlock(&server->deltas_lock);
+        
+        // the deltas were pushed on the front of the list, so it's reversed to apply them in order
+        Delta *ordered = NULL;
+        while(deltas != NULL)
+        {
+            Delta *next = deltas->next;
+            deltas->next = ordered;
+            ordered = deltas;
+            deltas = next;
+        }
+        
+        Snapshot *old = server->current;
+        Snapshot *snapshot = (Snapshot*) malloc(sizeof(Snapshot));
+        snapshot->grid = (bool*) malloc(grid_size(cols, rows) * sizeof(bool));
+        snapshot->owned = true;
+        snapshot->version = old->version + 1;
+        memcpy(snapshot->grid, old->grid, grid_size(cols, rows) * sizeof(bool));
+        
+        // a delta with a cell outside the map is refused as a whole
+        for(Delta *d = ordered ; d != NULL ; d = d->next)
+        {
+            bool valid = true;
+            for(uint32_t i = 0 ; i < d->nb && valid ; i++)
+                valid = in_range(((Loc){d->cells[i].x, d->cells[i].y}), cols, rows);
+            
+            if(!valid)
+            {
+                d->refused = true;
+                continue;
+            }
+            
+            for(uint32_t i = 0 ; i < d->nb ; i++)
+                grid_get_at(snapshot->grid, cols, ((Loc){d->cells[i].x, d->cells[i].y})) = d->cells[i].passable != 0;
+        }
+        
+        // queries that start from now on read the new snapshot, the old one is freed once no query reads it
+        __atomic_store_n(&server->current, snapshot, __ATOMIC_SEQ_CST);
+        if(old->owned)
+        {
+            old->retired_at = __atomic_fetch_add(&server->epoch, 1, __ATOMIC_SEQ_CST);
+            old->next = retired;
+            retired = old;
+        }
+        reclaim_snapshots(server, &retired);
+        
+        while(ordered != NULL)
+        {
+            Delta *next = ordered->next;
+            Response_Header header = {.id = ordered->id, .status = ordered->refused ? STATUS_BAD_REQUEST : STATUS_OK};
+            send_answer(ordered->conn, header, &snapshot->version, header.status == STATUS_OK ? sizeof(snapshot->version) : 0);
+            free(ordered);
+            ordered = next;
+        }
+    }
+    
+    return NULL;
+}
+
+int run_server(const char *map_path, const char *socket_path, int nb_threads)
+{
+    static Server server;
+    if(!load_map(map_path, &server.map))
+        return 1;
+    
+    pthread_mutex_init(&server.queue.lock, NULL);
+    pthread_cond_init(&server.queue.not_empty, NULL);
+    pthread_cond_init(&server.queue.not_full, NULL);
+    pthread_mutex_init(&server.deltas_lock, NULL);
+    pthread_cond_init(&server.deltas_ready, NULL);
+    
+    // the loaded map is the first snapshot, the workers announce epochs from 1 on
+    static Snapshot first;
+    first.grid = server.map.grid;
+    server.current = &first;
+    server.epoch = 1;
+    
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if(strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "The socket path '%s' is too long\n", socket_path);
+        free_map(&server.map);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    
+    // a socket left by a previous server would make bind fail
+    unlink(socket_path);
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd == -1
+       || bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) == -1
+       || listen(listen_fd, SOMAXCONN) == -1)
+    {
+        fprintf(stderr, "Can't listen on '%s': %s\n", socket_path, strerror(errno));
+        free_map(&server.map);
+        return 1;
+    }
+    
+    // a client closing its connection early must not kill the server when its answers are written
+    signal(SIGPIPE, SIG_IGN);
+    
+    if(nb_threads <= 0)
+        nb_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    server.nb_workers = nb_threads;
+    server.worker_epochs = (Worker_Epoch*) aligned_alloc(64, nb_threads * sizeof(Worker_Epoch));
+    memset(server.worker_epochs, 0, nb_threads * sizeof(Worker_Epoch));
+    
+    for(int i = 0 ; i < nb_threads ; i++)
+    {
+        Worker_Arg *arg = (Worker_Arg*) malloc(sizeof(Worker_Arg));
+        arg->server = &server;
+        arg->index = i;
+        
+        pthread_t thread;
+        pthread_create(&thread, NULL, answer_queries, arg);
+        pthread_detach(thread);
+    }
+    
+    pthread_t writer;
+    pthread_create(&writer, NULL, apply_deltas, &server);
+    pthread_detach(writer);
+    
+    fprintf(stderr, "Serving the %dx%d map on '%s' with %d threads\n", server.map.cols, server.map.rows, socket_path, nb_threads);
+    
+    while(1)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if(fd == -1)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            fprintf(stderr, "Can't accept a connection: %s\n", strerror(errno));
+            break;
+        }
+        
+        Reader_Arg *arg = (Reader_Arg*) malloc(sizeof(Reader_Arg));
+        arg->server = &server;
+        arg->fd = fd;
+        
+        pthread_t thread;
+        pthread_create(&thread, NULL, read_requests, arg);
+        pthread_detach(thread);
+    }
+    
+    close(listen_fd);
+    unlink(socket_path);
+    return 1;
+}
@@ -0,0 +1,45 @@
+#ifndef GRID_FILE_H
+#define GRID_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "path_finder.h"
+
+// A binary grid file is a header followed by the obstacles grid, one byte per cell (1 passable, 0 unpassable)
+// it's the same format the CLI reads and writes with --load and --save, so maps go from one to the other
+// the payload is laid out exactly like the obstacles in memory, so it's read straight into them without parsing
+#define GRID_FILE_MAGIC   "PFGRID\r\n"
+#define GRID_FILE_VERSION 1
+
+// the payload starts at this offset, so it is page aligned when mapped by the CLI
+#define GRID_FILE_PAYLOAD_OFFSET 4096
+
+// set in the header's flags if the payload is stored in the tiled layout of the CLI, which the GUI doesn't use
+#define GRID_FILE_TILED 1
+
+// The header at the start of a binary grid file, all fields are in the byte order of the machine that wrote it
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int32_t cols;
+    int32_t rows;
+    int32_t start_x; // -1 if the start point isn't set
+    int32_t start_y;
+    int32_t end_x;   // -1 if the end point isn't set
+    int32_t end_y;
+    uint64_t payload_offset;
+    uint64_t payload_size;
+} Grid_File_Header;
+
+// Reads a binary grid file, replacing the obstacles with a new array read straight from the payload
+// the start/end points are null_loc if they aren't set or aren't within the grid
+// Returns false and prints the reason to stderr if the file can't be read, the obstacles and everything else are then left as they were
+bool load_grid_file(const char *path, bool **obstacles, int *cols, int *rows, Loc *start, Loc *end);
+
+// Writes the obstacles and the start/end points to a binary grid file
+// Returns false and prints the reason to stderr if the file can't be written
+bool save_grid_file(const char *path, const bool *obstacles, int cols, int rows, Loc start, Loc end);
+
+#endif
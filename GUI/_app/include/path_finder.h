@@ -2,6 +2,7 @@
 #define PATH_FINDER
 
 #include <stdbool.h>
+#include <stdatomic.h>
 
 // a convenience macro for accessing a 2D point in a 1D array
 #define grid_get_at(grid, cols, loc) \
@@ -51,9 +52,81 @@ typedef struct
     bool visited;
 } Cell;
 
+// Counts the work done by a search, only filled when built with PATH_FINDER_STATS
+// the times of the phases are measured when also built with PATH_FINDER_STATS_TIME, which reads the clock a few times per search
+// the times of every pop, push and expansion are only measured when built with PATH_FINDER_STATS_OP_TIME, which slows the search down a lot
+typedef struct
+{
+    long long expanded;      // cells taken out of the queue and expanded
+    long long pushes;        // cells put in the queue, not counting the decrease-keys
+    long long pops;          // cells taken out of the queue
+    long long decrease_keys; // cells already in the queue that got a cheaper cost
+    int max_queue_size;
+    long long pop_ns;        // time spent taking cells out of the queue, only with PATH_FINDER_STATS_OP_TIME
+    long long push_ns;       // time spent putting cells in the queue or decreasing their cost, only with PATH_FINDER_STATS_OP_TIME
+    long long expand_ns;     // time spent checking the neighbours of expanded cells without the pushes, only with PATH_FINDER_STATS_OP_TIME
+    long long grid_ns;       // time the caller spent reading the grid before the search, not filled by the search
+    long long reset_ns;      // time spent clearing the cells and the queue of the last search
+    long long search_ns;     // time spent stepping the search, from the first expansion to the last
+    long long path_ns;       // time spent following the parents from start to end, filled by whoever gets the path
+} Search_Stats;
+
+// Lets another thread follow a search and stop it, see shortest_path_controlled in search.h
+typedef struct
+{
+    atomic_bool cancel;    // set to stop the search, it then returns no path
+    atomic_llong expanded; // the cells expanded so far, updated every few expansions
+} Search_Control;
+
+#ifdef PATH_FINDER_STATS_OP_TIME
+#ifndef PATH_FINDER_STATS_TIME
+#define PATH_FINDER_STATS_TIME
+#endif
+#endif
+
+#ifdef PATH_FINDER_STATS_TIME
+#ifndef PATH_FINDER_STATS
+#define PATH_FINDER_STATS
+#endif
+
+// Returns a monotonic time in nanoseconds
+long long stats_now_ns();
+
+// runs a statement and adds the time it took to a field of the stats
+#define stats_time(stats, field, statement) \
+do { const long long stats_begin_ = stats_now_ns(); statement; (stats)->field += stats_now_ns() - stats_begin_; } while(0)
+#else
+#define stats_time(stats, field, statement) \
+do { statement; } while(0)
+#endif
+
+// same as stats_time, for the operations done for every cell, which are only timed with PATH_FINDER_STATS_OP_TIME
+#ifdef PATH_FINDER_STATS_OP_TIME
+#define stats_op_time(stats, field, statement) \
+stats_time(stats, field, statement)
+#else
+#define stats_op_time(stats, field, statement) \
+do { statement; } while(0)
+#endif
+
+#ifdef PATH_FINDER_STATS
+#define stats_add(stats, field, n) \
+((stats)->field += (n))
+#define stats_max(stats, field, n) \
+((stats)->field = (stats)->field > (n) ? (stats)->field : (n))
+#else
+#define stats_add(stats, field, n) \
+((void) 0)
+#define stats_max(stats, field, n) \
+((void) 0)
+#endif
+
 // Returns the shortest path from start to end, avoiding obstacles on the grid
 Path shortest_path(const bool *grid, int cols, int rows, Loc start, Loc end);
 
+// Same as shortest_path, and fills 'stats' with the work the search did if it's not NULL
+Path shortest_path_with_stats(const bool *grid, int cols, int rows, Loc start, Loc end, Search_Stats *stats);
+
 // Applies a direction to a given location
 // Retruns the resulting location
 Loc next_loc(Loc loc, Parent_Direction direction);
@@ -0,0 +1,54 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "path_finder.h"
+#include "priority_queue.h"
+
+// What a search is at after being stepped
+typedef enum
+{
+    SEARCH_RUNNING   = 0, // the search isn't done, step it again
+    SEARCH_FOUND     = 1, // the path is found, get it with search_path
+    SEARCH_NOT_FOUND = 2
+} Search_Status;
+
+// A search that can be run a few expansions at a time, see search_begin and search_step
+// the search goes from end to start, and is done once start is expanded
+typedef struct
+{
+    const bool *grid;
+    int cols;
+    int rows;
+    Loc start;
+    Loc end;
+
+    Cell *cells; // the state of every cell of the grid, only grown
+    int cells_cap;
+    Priority_Queue unexpanded;
+
+    Search_Status status;
+    long long expanded; // counted even without the stats
+    Loc expanded_loc;   // the cell expanded last, null_loc if none was
+    Search_Stats stats; // final once the search is done
+} Search;
+
+// Starts a search from start to end, reusing the memory of the last search made with 'search'
+// the grid must stay as it is until the search is done or dropped
+void search_begin(Search *search, const bool *grid, int cols, int rows, Loc start, Loc end);
+
+// Expands up to 'max_expansions' cells, stopping early if the search is done
+// Returns where the search is at
+Search_Status search_step(Search *search, long long max_expansions);
+
+// Returns the path of a search that found it, or no path
+Path search_path(const Search *search);
+
+// Frees the memory of the search
+void free_search(Search *search);
+
+// Same as shortest_path_with_stats, reusing the memory of the last search made with 'search',
+// and checks 'control' every few expansions if it's not NULL
+// if the search was cancelled through it, returns no path
+Path shortest_path_controlled(Search *search, const bool *grid, int cols, int rows, Loc start, Loc end, Search_Stats *stats, Search_Control *control);
+
+#endif
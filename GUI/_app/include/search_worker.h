@@ -0,0 +1,57 @@
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "path_finder.h"
+#include "search.h"
+
+// Runs searches on a thread of its own, so the window keeps drawing while they run
+// each search reads the obstacles as they are, without copying them, so they must not change while it runs
+typedef struct
+{
+    // the obstacles the search runs on, not owned by the worker
+    const bool *grid;
+    int cols;
+    int rows;
+    Loc start;
+    Loc end;
+    
+    // the passable cells of the grid, the most cells the search can expand
+    long long passable;
+    
+    // the result, only read once the search is finished
+    Path path;
+    Search_Stats stats;
+    double time_taken;
+    
+    // the memory of the searches, kept from one to the next and only used by the search thread
+    Search search;
+    
+    Search_Control control;
+    atomic_bool done;
+    pthread_t thread;
+    bool running; // a thread was started and not joined yet
+} Search_Worker;
+
+// Starts a search from start to end on the obstacles, cancelling the one running if any
+// the obstacles must stay as they are until the search is finished or cancelled
+void start_search(Search_Worker *worker, const bool *obstacles, int cols, int rows, Loc start, Loc end);
+
+// Stops the running search if any and waits for it, its result is dropped
+void cancel_search(Search_Worker *worker);
+
+// Returns true once when a search finished, its result is then in the worker and owned by the caller
+bool search_finished(Search_Worker *worker);
+
+// Returns true if a search is running
+bool search_running(const Search_Worker *worker);
+
+// Returns how far the running search is, from 0 to 1
+float search_progress(Search_Worker *worker);
+
+// Cancels the running search and clears the worker
+void free_search_worker(Search_Worker *worker);
+
+#endif
@@ -26,6 +26,15 @@ project (baseName)
     includedirs { "src" }
     includedirs { "include" }
     
+    -- the Result pop-up shows what the search did and how long each phase of it took, which costs a few clock readings per search
+    -- add PATH_FINDER_STATS_OP_TIME to also time every pop, push and expansion, it slows the searches down a lot
+    defines { "PATH_FINDER_STATS_TIME" }
+    
     link_raylib()
+    
+    -- the searches run on a thread of their own
+    filter "action:gmake*"
+        links { "pthread" }
+    filter {}
 	
 	-- To link to a lib use link_to("LIB_FOLDER_NAME")
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include "../include/grid_file.h"
+
+// checks that a header describes a valid grid in a file of 'file_size' bytes
+static bool valid_header(const Grid_File_Header *header, long long file_size, const char *path)
+{
+    if(memcmp(header->magic, GRID_FILE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        fprintf(stderr, "'%s' is not a grid file\n", path);
+        return false;
+    }
+    if(header->version != GRID_FILE_VERSION)
+    {
+        fprintf(stderr, "'%s' has unsupported version %u\n", path, header->version);
+        return false;
+    }
+    if(header->flags & GRID_FILE_TILED)
+    {
+        fprintf(stderr, "'%s' was saved in the tiled layout, save it again with a CLI built without PATH_FINDER_TILED\n", path);
+        return false;
+    }
+    
+    // the GUI indexes the cells with an int
+    if(header->cols <= 0 || header->rows <= 0 || (long long) header->cols * header->rows > INT_MAX)
+    {
+        fprintf(stderr, "'%s' has invalid dimensions %dx%d\n", path, header->cols, header->rows);
+        return false;
+    }
+    // the offset and size are checked one at a time against the file size, so a huge offset can't wrap around
+    if(header->payload_size != (uint64_t) header->cols * header->rows
+       || header->payload_offset < sizeof(Grid_File_Header)
+       || header->payload_offset % GRID_FILE_PAYLOAD_OFFSET != 0
+       || header->payload_offset > (uint64_t) file_size
+       || header->payload_size > (uint64_t) file_size - header->payload_offset)
+    {
+        fprintf(stderr, "'%s' is truncated or corrupted\n", path);
+        return false;
+    }
+    
+    return true;
+}
+
+// returns the point if it's within the grid, null_loc otherwise
+static Loc loc_within(int x, int y, int cols, int rows)
+{
+    Loc loc = {x, y};
+    return within_grid(loc, cols, rows) ? loc : null_loc;
+}
+
+bool load_grid_file(const char *path, bool **obstacles, int *cols, int *rows, Loc *start, Loc *end)
+{
+    FILE *f = fopen(path, "rb");
+    if(f == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    Grid_File_Header header;
+    long long file_size = -1;
+    if(fseek(f, 0, SEEK_END) == 0)
+        file_size = ftell(f);
+    
+    if(file_size < (long long) sizeof(header) || fseek(f, 0, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, f) != 1)
+    {
+        fprintf(stderr, "'%s' is not a grid file\n", path);
+        fclose(f);
+        return false;
+    }
+    
+    if(!valid_header(&header, file_size, path))
+    {
+        fclose(f);
+        return false;
+    }
+    
+    // the payload is read into the array that becomes the obstacles, it's one byte per cell like them
+    bool *grid = malloc(header.payload_size);
+    bool ok = grid != NULL
+           && fseek(f, header.payload_offset, SEEK_SET) == 0
+           && fread(grid, header.payload_size, 1, f) == 1;
+    fclose(f);
+    
+    if(!ok)
+    {
+        fprintf(stderr, "Can't read '%s'\n", path);
+        free(grid);
+        return false;
+    }
+    
+    // any non zero byte is passable, so every cell is a valid bool even if the file wasn't written by the GUI or the CLI
+    unsigned char *bytes = (unsigned char*) grid;
+    for(uint64_t i = 0 ; i < header.payload_size ; i++)
+        bytes[i] = bytes[i] != 0;
+    
+    free(*obstacles);
+    *obstacles = grid;
+    *cols  = header.cols;
+    *rows  = header.rows;
+    *start = loc_within(header.start_x, header.start_y, header.cols, header.rows);
+    *end   = loc_within(header.end_x, header.end_y, header.cols, header.rows);
+    
+    return true;
+}
+
+bool save_grid_file(const char *path, const bool *obstacles, int cols, int rows, Loc start, Loc end)
+{
+    FILE *f = fopen(path, "wb");
+    if(f == NULL)
+    {
+        fprintf(stderr, "Can't open '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    Grid_File_Header header = {
+        .version = GRID_FILE_VERSION,
+        .flags   = 0,
+        .cols    = cols,
+        .rows    = rows,
+        .start_x = start.x,
+        .start_y = start.y,
+        .end_x   = end.x,
+        .end_y   = end.y,
+        .payload_offset = GRID_FILE_PAYLOAD_OFFSET,
+        .payload_size   = (uint64_t) cols * rows
+    };
+    memcpy(header.magic, GRID_FILE_MAGIC, sizeof(header.magic));
+    
+    // the header is padded with zeros up to the payload offset
+    static const char padding[GRID_FILE_PAYLOAD_OFFSET] = {0};
+    
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+           && fwrite(padding, GRID_FILE_PAYLOAD_OFFSET - sizeof(header), 1, f) == 1
+           && fwrite(obstacles, header.payload_size, 1, f) == 1;
+    
+    if(fclose(f) != 0 || !ok)
+    {
+        fprintf(stderr, "Can't write '%s'\n", path);
+        return false;
+    }
+    
+    return true;
+}
@@ -3,10 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 #include "../include/path_finder.h"
-#define STB_DS_IMPLEMENTATION
-#include "../libs/stb_ds.h"
+#include "../include/search_worker.h"
+#include "../include/search.h"
+#include "../include/grid_file.h"
 #define RAYGUI_IMPLEMENTATION
 #include "../include/iconset.rgi.h"
 #include "../libs/raygui.h"
@@ -20,15 +22,90 @@ typedef struct
     bool held;
 } Cell_Click;
 
-// draws a grid given the top left point and the rows and columns
+// a rectangle of cells, empty when its width is 0
+typedef struct
+{
+    int x;
+    int y;
+    int width;
+    int height;
+} Cell_Rect;
+
+// the obstacles as a texture with one texel per cell, drawn as a single scaled quad
+// only the cells changed since the last frame are uploaded again
+typedef struct
+{
+    Texture2D texture;
+    int cols;
+    int rows;
+    
+    // the cells changed since the last upload
+    Cell_Rect dirty;
+} Obstacles_Texture;
+
+// a stroke of obstacle painting, from when right click is pressed to when it's released
+// the first cell clicked decides whether the stroke sets or unsets obstacles, like a toggle
+typedef struct
+{
+    bool active;
+    bool rectangle; // the rectangle from 'from' to 'last' is filled when released, instead of painting along the way
+    bool passable;  // what the cells are set to
+    Loc from;       // the cell the stroke started on
+    Loc last;       // the cell the brush was last on, or the opposite corner of the rectangle
+} Obstacle_Stroke;
+
+// the path as runs of cells per row, so only the part of it in view is drawn and each run is a single rectangle
+typedef struct
+{
+    Cell_Rect *spans; // the runs of the path, a single row high, sorted by row then by column
+    int nb;
+    int cap;
+    
+    int *row_first;   // the runs of row y are from row_first[y] to row_first[y + 1]
+    int rows;         // the rows the path goes through, from the first row
+    int rows_cap;
+    
+    int *xs;          // the columns of the path cells sorted by row, used while indexing
+    int xs_cap;
+} Path_Spans;
+
+// the number of searches shown in the timing graph of the Result pop-up
+#define TIMING_HISTORY 64
+
+// the stats of the last searches, to graph where their time went
+typedef struct
+{
+    Search_Stats searches[TIMING_HISTORY]; // a ring, 'next' is the oldest search once it's full
+    int nb;
+    int next;
+} Timing_History;
+
+// a search shown a few expansions per frame, the cells it expanded, its frontier and the path are drawn in a texture
+typedef struct
+{
+    Search search;
+    bool running;      // the search isn't done, it's stepped every frame
+    bool shown;        // the texture is drawn over the grid
+    double time_taken; // the time spent stepping the search
+    
+    Texture2D texture; // one texel per cell
+    int cols;
+    int rows;
+    Color *texels;     // the color of every cell, whole rows of it are uploaded
+    
+    // the cells changed since the last upload
+    Cell_Rect dirty;
+} Search_Animation;
+
+// highlights the hovered cell of a grid given the top left point and the rows and columns
 // returns the cell that was clicked
-Cell_Click draw_grid(Vector2 topleft, int cols, int rows, Rectangle view, int panel_borderx);
+Cell_Click draw_grid(Vector2 topleft, int cols, int rows, int panel_borderx);
 
-// grows/shrinks the obstacles grid according to the new rows/cols
-void resize_obstacles(bool ***obstacles, int cols, int rows);
+// draws the lines between the cells of the grid, as a tiled texture
+void draw_grid_lines(Vector2 topleft, int cols, int rows);
 
-// returns a heap allocated 1D array from an array of bool arrays
-bool *obstacles_2d_to_1d(bool **obstacles);
+// grows/shrinks the obstacles grid according to the new rows/cols, keeping the obstacles that are still within it
+void resize_obstacles(bool **obstacles, int old_cols, int old_rows, int cols, int rows);
 
 // scrolls the grid if dragging it with mouse
 void scroll_by_dragging_mouse(Cell_Click cell_click, Vector2 *scroll);
@@ -36,12 +113,31 @@ void scroll_by_dragging_mouse(Cell_Click cell_click, Vector2 *scroll);
 // moves the popup window if dragging it with mouse
 void move_popup_by_dragging_mouse(Rectangle *popup_bounds);
 
-// calls the shortest path algorithm and sets the path
-// sets the cost and time strings to reflect the result of the algorithm
-void set_path(Path *path, bool **obstacles, int cols, int rows, Loc start, Loc end, char *cost_str, char *time_str);
+// the number of lines of search stats shown in the Result pop-up
+#define STATS_LINES 4
+
+// sets the path to the result of a finished search
+// sets the cost, time and stats strings to reflect the result of the algorithm
+void set_path(Path *path, Path result, Search_Stats stats, double time_taken, char *cost_str, char *time_str, char stats_str[STATS_LINES][64]);
+
+// indexes the cells of the path by row, merging the cells next to each other into runs
+void index_path(Path_Spans *spans, Path path);
+
+// draws the runs of the path that are within 'view' as green rectangles, covering the lines between their cells
+void draw_path(const Path_Spans *spans, Vector2 topleft, Rectangle view);
+
+// frees the memory of the path index
+void free_path_spans(Path_Spans *spans);
 
-// draws the path as green squares on the grid
-void draw_path(Path path, Vector2 topleft);
+// adds the stats of a finished search to the timing history, dropping the oldest if it's full
+void record_timings(Timing_History *history, Search_Stats stats);
+
+// draws the time the searches of the history spent on each phase as stacked bars, the most recent on the right
+// the grid pass in gray, the reset in orange, the expansions in blue and the path extraction in green
+void draw_timings(const Timing_History *history, Rectangle bounds);
+
+// returns the difference between two times as a double
+double diff_timespec(struct timespec time1, struct timespec time0);
 
 // draws the row/col spinners and updates the rows and cols
 bool draw_spinners_and_update_rows_cols(Rectangle r_spinner, Rectangle c_spinner, int *rows, int *cols);
@@ -49,26 +145,81 @@ bool draw_spinners_and_update_rows_cols(Rectangle r_spinner, Rectangle c_spinner
 // draws the row/col spinners without updating values
 bool draw_spinners(Rectangle r_spinner, Rectangle c_spinner, int rows, int cols);
 
-// draws the obstacles on the grid as red squares
-void draw_obstacles(bool **obstacles, int cols, int rows, Vector2 topleft, Rectangle view);
+// grows a rectangle of cells so it also holds another one
+void grow_cell_rect(Cell_Rect *rect, int x, int y, int width, int height);
+
+// marks cells of the obstacles texture as changed, so they're uploaded before it's drawn
+void mark_obstacles_dirty(Obstacles_Texture *texture, int x, int y, int width, int height);
+
+// uploads the changed cells to the obstacles texture, making a new texture if the grid was resized
+void upload_obstacles(Obstacles_Texture *texture, const bool *obstacles, int cols, int rows);
+
+// draws the obstacles on the grid as red squares, with a single quad
+void draw_obstacles(const Obstacles_Texture *texture, Vector2 topleft);
+
+// starts showing a search from start to end, the obstacles must not change until it's stopped
+void start_animation(Search_Animation *animation, const bool *obstacles, int cols, int rows, Loc start, Loc end);
+
+// expands up to 'expansions' cells of the animated search and colors them
+// returns true once when the search is done, with its path in 'result'
+bool step_animation(Search_Animation *animation, long long expansions, Path *result);
+
+// stops the animated search and stops drawing it
+void stop_animation(Search_Animation *animation);
+
+// uploads the changed cells of the animated search and draws it over the grid, with a single quad
+void draw_animation(Search_Animation *animation, Vector2 topleft);
 
 // removes all the obstacles from the grid
-void clear_obstacles(bool ***obstacles, int cols, int rows);
+void clear_obstacles(bool *obstacles, int cols, int rows);
+
+// sets the cells of a rectangle to passable or not, a row at a time, keeping Start and End passable
+// returns the part of the rectangle within the grid, which is what changed
+Cell_Rect fill_obstacles(bool *obstacles, int cols, int rows, Cell_Rect rect, bool passable, Loc start, Loc end);
+
+// paints a square brush of 'radius' cells around each cell of the line from 'from' to 'to'
+// returns the rectangle holding all the cells that changed
+Cell_Rect paint_obstacles(bool *obstacles, int cols, int rows, Loc from, Loc to, int radius, bool passable, Loc start, Loc end);
+
+// returns the rectangle of cells between two corners, both included
+Cell_Rect rect_between(Loc l1, Loc l2);
+
+// returns the bounds of a rectangle of cells on the screen, without the lines around it
+Rectangle screen_rect(Cell_Rect rect, Vector2 topleft);
 
 // clamps a float between 2 int values
 int iclampf(float f, int min, int max);
 
 bool within_rect(int x, int y, Rectangle rect);
 
-// a convinence macro used to clear the path (free and NULL it, set cost string to empty)
+// a convinence macro used to clear the path (cancel the search, free and NULL it, set cost string to empty)
 #define clear_path() \
 do { \
+    cancel_search(&worker); \
+    stop_animation(&animation); \
     free(path.locs); \
     path = (Path){0}; \
+    index_path(&path_spans, path); \
     popup_open = false; \
     cost_str[0] = '\0'; \
 } while(0)
 
+// a convinence macro used when the grid or Start/End changed
+// clears the path, or in live mode keeps it shown until it's found again at the end of the frame
+#define path_changed() \
+do { \
+    if(live) \
+    { \
+        cancel_search(&worker); \
+        stop_animation(&animation); \
+        live_changed = true; \
+    } \
+    else \
+    { \
+        clear_path(); \
+    } \
+} while(0)
+
 // a convinence macro for setting a select mode
 #define set_select_mode(mode) \
 do { \
@@ -120,20 +271,17 @@ int main()
     Loc start = {0, 0};
     Loc end   = {INITIAL_COLS - 1, INITIAL_ROWS - 1};
     
-    // initialize the obstacles
-    bool **obstacles = NULL;
-    arrsetlen(obstacles, rows);
-    for(int i = 0 ; i < rows ; i++)
-    {
-        obstacles[i] = NULL;
-        arrsetlen(obstacles[i], cols);
-        for(int j = 0 ; j < cols ; j++)
-            obstacles[i][j] = true;
-    }
+    // initialize the obstacles, a single array of rows * cols cells where true is passable
+    // the searches read it as is, so it's only changed when no search is running
+    bool *obstacles = malloc(rows * cols * sizeof(bool));
+    clear_obstacles(obstacles, cols, rows);
     
     // the path describes the locations of the cells from start to end
     Path path = { 0 };
     
+    // the path indexed by row, to only draw the part of it in view
+    Path_Spans path_spans = { 0 };
+    
     // this string will be displayed to show the path cost
     // "Cost: " => 6
     // "%.2f"   => 13
@@ -146,11 +294,47 @@ int main()
     // '\0'     => 1
     char time_str[6 + 30 + 1] = "";
     
+    // these strings will be displayed to show what the search did, when the stats are counted
+    char stats_str[STATS_LINES][64] = {""};
+    
+    // the time spent on each phase of the last searches, graphed in the pop-up when the stats are timed
+    Timing_History timing_history = { 0 };
+    
+    // the time spent making the last frame, without waiting for the next one
+    double render_time = 0;
+    
     // if true the pop-up window showing the cost and time taken will appear
     bool popup_open = false;
     
-    // the location of the last obstacle set, used to not set/unset the same cell when right click is held
-    Loc last_obstacle_changed = null_loc;
+    // runs the searches, so the window keeps drawing while they do
+    Search_Worker worker = { 0 };
+    
+    // in live mode the path is found again after every change, toggled with L
+    bool live = false;
+    
+    // true if something changed this frame in live mode, all the changes of a frame start a single search
+    bool live_changed = false;
+    
+    // when animating, the search is shown a few expansions per frame instead of running on the worker, toggled with A
+    bool animate = false;
+    Search_Animation animation = { 0 };
+    
+    // the cells expanded per frame when animating, halved with '[' and doubled with ']'
+    long long animation_speed = 16;
+    
+    // the obstacles as they're drawn, made with the first upload
+    Obstacles_Texture obstacles_texture = { 0 };
+    
+    // right click/drag paints obstacles with the brush, holding shift fills a rectangle instead
+    // the edits of a stroke are applied a row span at a time, with a single path invalidation for the whole stroke
+    Obstacle_Stroke stroke = { 0 };
+    
+    // the cells painted around the one under the brush, decreased with ',' and increased with '.'
+    int brush_radius = 0;
+    
+    // the binary grid file saved with Ctrl+S and loaded with Ctrl+O, a file dropped on the window becomes it
+    char map_path[1024] = "map.grid";
+    char title[sizeof(map_path) + 16];
     
     // set up the window
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
@@ -165,7 +349,7 @@ int main()
     // represents what's inside the scroll panel, i.e its conent
     Rectangle scroll_panel_content = { 0 };
     
-    // represents the sub-rectangle inside scroll_panel_content that is in view (unused)
+    // represents the part of the scroll panel the grid is seen through, used to only draw the path in view
     Rectangle scroll_view = { 0 };
     
     // represents the bounds of the buttons panel
@@ -232,12 +416,21 @@ int main()
         .height = r_spinner.height
     };
     
+    // the pop-up is taller when it also shows the search stats, and the timing graph when they're timed
+#if defined(PATH_FINDER_STATS_TIME)
+    const int popup_height = 640;
+#elif defined(PATH_FINDER_STATS)
+    const int popup_height = 384;
+#else
+    const int popup_height = 256;
+#endif
+    
     // represents the bounds of the pop-up window
     Rectangle popup_bounds = {
         .x = (GetScreenWidth() / 2.0f) - (512 / 2.0f),
-        .y = (GetScreenHeight() / 2.0f) - (256 / 2.0f),
+        .y = (GetScreenHeight() / 2.0f) - (popup_height / 2.0f),
         .width  = 512,
-        .height = 256
+        .height = popup_height
     };
     
     // loading the style
@@ -252,6 +445,9 @@ int main()
     
     while(!WindowShouldClose())
     {
+        struct timespec frame_begin;
+        clock_gettime(CLOCK_MONOTONIC, &frame_begin);
+        
         mousex_old = mousex;
         mousey_old = mousey;
         mousex = GetMouseX();
@@ -296,6 +492,81 @@ int main()
             cell_size+=2;
         }
         
+        // toggle live mode if 'L' is pressed, the path is found right away when it's turned on
+        if(IsKeyPressed(KEY_L))
+        {
+            live = !live;
+            live_changed = live;
+        }
+        
+        // toggle animating if 'A' is pressed, and change its speed if '[' or ']' are pressed
+        if(IsKeyPressed(KEY_A))
+        {
+            animate = !animate;
+        }
+        if(animation_speed > 1 && IsKeyPressed(KEY_LEFT_BRACKET))
+        {
+            animation_speed /= 2;
+        }
+        if(animation_speed < (1 << 20) && IsKeyPressed(KEY_RIGHT_BRACKET))
+        {
+            animation_speed *= 2;
+        }
+        
+        // change the brush size if ',' or '.' are pressed
+        if(brush_radius > 0 && IsKeyPressed(KEY_COMMA))
+        {
+            brush_radius--;
+        }
+        if(brush_radius < 64 && IsKeyPressed(KEY_PERIOD))
+        {
+            brush_radius++;
+        }
+        
+        // save the grid if Ctrl+S is pressed, and load it back if Ctrl+O is
+        bool ctrl_down = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+        const char *load_path = NULL;
+        if(ctrl_down && IsKeyPressed(KEY_S) && save_grid_file(map_path, obstacles, cols, rows, start, end))
+        {
+            snprintf(title, sizeof(title), "Path Finder - %s", map_path);
+            SetWindowTitle(title);
+        }
+        if(ctrl_down && IsKeyPressed(KEY_O))
+        {
+            load_path = map_path;
+        }
+        
+        // a file dropped on the window is loaded, and saved to with Ctrl+S from then on
+        bool file_dropped = IsFileDropped();
+        FilePathList dropped = { 0 };
+        if(file_dropped)
+        {
+            dropped = LoadDroppedFiles();
+            if(dropped.count > 0)
+                load_path = dropped.paths[0];
+        }
+        
+        if(load_path != NULL)
+        {
+            no_select();
+            
+            // the search reads the obstacles, so it's stopped before they're replaced
+            path_changed();
+            
+            if(load_grid_file(load_path, &obstacles, &cols, &rows, &start, &end))
+            {
+                mark_obstacles_dirty(&obstacles_texture, 0, 0, cols, rows);
+                
+                if(load_path != map_path)
+                    snprintf(map_path, sizeof(map_path), "%s", load_path);
+                snprintf(title, sizeof(title), "Path Finder - %s", map_path);
+                SetWindowTitle(title);
+            }
+        }
+        
+        if(file_dropped)
+            UnloadDroppedFiles(dropped);
+        
         BeginDrawing();
         
         ClearBackground(WHITE);
@@ -310,20 +581,38 @@ int main()
         };
         
         // draw the grid and get the clicked cell
-        Cell_Click clicked_cell = draw_grid(grid_topleft, cols, rows, scroll_view, scroll_panel.x);
+        Cell_Click clicked_cell = draw_grid(grid_topleft, cols, rows, scroll_panel.x);
         
         // checks whether a cell is clicked
         bool cell_is_clicked = !locs_eq(clicked_cell.loc, null_loc);
         
-        // checks whether the same cell being held, useful for obstacle placing
-        bool holding_same_obstacle_cell = cell_is_clicked && clicked_cell.held && locs_eq(clicked_cell.loc, last_obstacle_changed);
-        
         if(!popup_open || ((mousex <= popup_bounds.x || mousex >= popup_bounds.x + popup_bounds.width) || (mousey <= popup_bounds.y || mousey >= popup_bounds.y + popup_bounds.height)))
             scroll_by_dragging_mouse(clicked_cell, &scroll);
         
-        draw_obstacles(obstacles, cols, rows, grid_topleft, scroll_view);
+        upload_obstacles(&obstacles_texture, obstacles, cols, rows);
+        draw_obstacles(&obstacles_texture, grid_topleft);
+        
+        // the animated search is drawn with its own path
+        draw_animation(&animation, grid_topleft);
         
-        draw_path(path, grid_topleft);
+        // the runs of the path cover the lines between their cells, which are drawn over them
+        if(!animation.shown)
+            draw_path(&path_spans, grid_topleft, scroll_view);
+        
+        draw_grid_lines(grid_topleft, cols, rows);
+        
+        // outline the rectangle being filled, or the brush around the hovered cell if it covers more than the cell
+        const int pitch = cell_size + line_thickness;
+        Loc hovered = { (mousex - grid_topleft.x) / pitch, (mousey - grid_topleft.y) / pitch };
+        if(stroke.active && stroke.rectangle)
+        {
+            DrawRectangleLinesEx(screen_rect(rect_between(stroke.from, stroke.last), grid_topleft), line_thickness, stroke.passable ? DARKGRAY : RED);
+        }
+        else if(brush_radius > 0 && mousex >= scroll_panel.x && mousex >= grid_topleft.x && mousey >= grid_topleft.y && within_grid(hovered, cols, rows))
+        {
+            Cell_Rect brush = { hovered.x - brush_radius, hovered.y - brush_radius, 2 * brush_radius + 1, 2 * brush_radius + 1 };
+            DrawRectangleLinesEx(screen_rect(brush, grid_topleft), line_thickness, DARKGRAY);
+        }
         
         // draw the Start icon on the grid if within it
         if(within_grid(start, cols, rows))
@@ -332,7 +621,7 @@ int main()
                 grid_topleft.y + line_thickness + (start.y * (cell_size + line_thickness)),
                 cell_size / 16,
                 BLACK);
-            
+        
         // draw the end icon on the grid if within it
         if(within_grid(end, cols, rows))
             GuiDrawIcon(221,
@@ -349,49 +638,87 @@ int main()
         bool start_clicked = GuiButton(s_button, "#220#");
         bool end_clicked   = GuiButton(e_button, "#221#");
         
-        if(clear_clicked && !popup_open)
+        // in live mode the pop-up stays open, so the buttons and spinners work while it is
+        if(clear_clicked && (!popup_open || live))
         {
             // if Start/End is selected, unselect
             no_select();
             
-            // remove all obstacles
-            clear_obstacles(&obstacles, cols, rows);
+            // clear the path, which also stops the search reading the obstacles
+            path_changed();
             
-            // clear the path
-            clear_path();
+            // remove all obstacles
+            clear_obstacles(obstacles, cols, rows);
+            mark_obstacles_dirty(&obstacles_texture, 0, 0, cols, rows);
         }
         
-        if(start_clicked && !popup_open)
+        if(start_clicked && (!popup_open || live))
         {
             set_select_mode(START);
         }
         
-        if(end_clicked && !popup_open)
+        if(end_clicked && (!popup_open || live))
         {
             set_select_mode(END);
         }
         
         // if path button was clicked and the Start and End are set, execute the shortest_path algorithm
-        if(find_clicked && within_grid(start, cols, rows) && within_grid(end, cols, rows))
+        // not while painting, since the search would read the obstacles as they're changed
+        if(find_clicked && !stroke.active && within_grid(start, cols, rows) && within_grid(end, cols, rows))
         {
             no_select();
             
-            set_path(&path, obstacles, cols, rows, start, end, cost_str, time_str);
+            // the path and the result of the last search are cleared, the pop-up shows the progress until it's done
+            clear_path();
+            if(animate)
+                start_animation(&animation, obstacles, cols, rows, start, end);
+            else
+                start_search(&worker, obstacles, cols, rows, start, end);
+            time_str[0] = '\0';
+            for(int i = 0 ; i < STATS_LINES ; i++)
+                stats_str[i][0] = '\0';
             popup_open = true;
         }
         
+        // show the result of the search once it's done, or how far it got
+        // in live mode the labels keep the last result until the next one is done
+        if(search_finished(&worker))
+        {
+            set_path(&path, worker.path, worker.stats, worker.time_taken, cost_str, time_str, stats_str);
+            index_path(&path_spans, path);
+            record_timings(&timing_history, worker.stats);
+            popup_open = true;
+        }
+        else if(search_running(&worker) && !live)
+        {
+            sprintf(cost_str, "Searching... %d%%", (int) (100 * search_progress(&worker)));
+        }
+        
+        // step the animated search, pressing SPACE finishes it right away
+        Path animation_result;
+        if(step_animation(&animation, IsKeyPressed(KEY_SPACE) ? LLONG_MAX : animation_speed, &animation_result))
+        {
+            set_path(&path, animation_result, animation.search.stats, animation.time_taken, cost_str, time_str, stats_str);
+            index_path(&path_spans, path);
+            record_timings(&timing_history, animation.search.stats);
+        }
+        else if(animation.running)
+        {
+            snprintf(cost_str, sizeof(cost_str), "Expanded: %lld", animation.search.expanded);
+        }
+        
         // setting the font for rows/cols spinners
         font.baseSize = font_size_small;
         GuiSetFont(font);
         
-        //int old_rows = rows, old_cols = cols;
-        bool changed_rows_cols = popup_open ? draw_spinners(r_spinner, c_spinner, rows, cols) : draw_spinners_and_update_rows_cols(r_spinner, c_spinner, &rows, &cols);
+        int old_rows = rows, old_cols = cols;
+        bool changed_rows_cols = popup_open && !live ? draw_spinners(r_spinner, c_spinner, rows, cols) : draw_spinners_and_update_rows_cols(r_spinner, c_spinner, &rows, &cols);
         
         // resize the obstacles grid if rows/cols was changed
         if(changed_rows_cols)
         {
-            resize_obstacles(&obstacles, cols, rows);
-            clear_path();
+            path_changed();
+            resize_obstacles(&obstacles, old_cols, old_rows, cols, rows);
         }
         
         // if the pop-up window is open, draw it and the display the cost and time
@@ -402,7 +729,14 @@ int main()
             font.baseSize = font_size_small;
             GuiSetFont(font);
             
-            popup_open = !GuiWindowBox(popup_bounds, "Result");
+            popup_open = !GuiWindowBox(popup_bounds, live ? "Result (live)" : "Result");
+            
+            // closing the pop-up stops the search it shows
+            if(!popup_open)
+            {
+                cancel_search(&worker);
+                stop_animation(&animation);
+            }
             
             // setting the font for the cost and time labels
             font.baseSize = font_size_big;
@@ -429,6 +763,54 @@ int main()
             };
             
             GuiLabel(time_label_bounds, time_str);
+            
+            // the stats and the frame time are smaller, one line under the other
+            font.baseSize = font_size_small;
+            GuiSetFont(font);
+            
+            float stats_label_y = time_label_bounds.y + time_label_bounds.height + button_pad / 2.0f;
+#ifdef PATH_FINDER_STATS
+            for(int i = 0 ; i < STATS_LINES ; i++)
+            {
+                int stats_label_width = GetTextWidth(stats_str[i]);
+                Rectangle stats_label_bounds = {
+                    .x = popup_bounds.x + (popup_bounds.width / 2) - (stats_label_width / 2.0f),
+                    .y = stats_label_y,
+                    .width  = stats_label_width,
+                    .height = 24
+                };
+                
+                GuiLabel(stats_label_bounds, stats_str[i]);
+                stats_label_y += stats_label_bounds.height + 6;
+            }
+#endif
+            
+            // the frame time changes every frame, so it's not kept with the stats of the search
+            char render_str[64];
+            snprintf(render_str, sizeof(render_str), "Render: %.3f ms", render_time * 1000);
+            
+            int render_label_width = GetTextWidth(render_str);
+            Rectangle render_label_bounds = {
+                .x = popup_bounds.x + (popup_bounds.width / 2) - (render_label_width / 2.0f),
+                .y = stats_label_y,
+                .width  = render_label_width,
+                .height = 24
+            };
+            
+            GuiLabel(render_label_bounds, render_str);
+
+#ifdef PATH_FINDER_STATS_TIME
+            // the graph takes the rest of the pop-up
+            float graph_y = render_label_bounds.y + render_label_bounds.height + 6;
+            Rectangle graph_bounds = {
+                .x = popup_bounds.x + 24,
+                .y = graph_y,
+                .width  = popup_bounds.width - 48,
+                .height = popup_bounds.y + popup_bounds.height - 16 - graph_y
+            };
+            
+            draw_timings(&timing_history, graph_bounds);
+#endif
         }
         
         // have the cursor be normal or an S or an E depending on the select mode
@@ -454,7 +836,7 @@ int main()
                 GuiDrawIcon(220, mousex - (2 * cursor_icon_size), mousey - (2 * cursor_icon_size), cursor_icon_size, BLACK);
                 
                 // since we're in S cursor mode, clicking on a passable cell will put the Start point there
-                if(cell_is_clicked && clicked_cell.mouse_button == MOUSE_BUTTON_LEFT && !clicked_cell.held && obstacles[clicked_cell.loc.y][clicked_cell.loc.x] && mousex >= scroll_panel.x)
+                if(cell_is_clicked && clicked_cell.mouse_button == MOUSE_BUTTON_LEFT && !clicked_cell.held && grid_get_at(obstacles, cols, clicked_cell.loc) && mousex >= scroll_panel.x)
                 {
                     start.x = clicked_cell.loc.x;
                     start.y = clicked_cell.loc.y;
@@ -465,7 +847,7 @@ int main()
                     
                     // make cursor normal next frame, and clear path if it was drawn (since the grid was changed, the path might not apply anymore)
                     no_select();
-                    clear_path();
+                    path_changed();
                 }
                 break;
             case END:
@@ -473,7 +855,7 @@ int main()
                 GuiDrawIcon(221, mousex - (2 *cursor_icon_size), mousey - (2 * cursor_icon_size), cursor_icon_size, BLACK);
                 
                 // since we're in E cursor mode, clicking on a passable cell will put the End point there
-                if(cell_is_clicked && clicked_cell.mouse_button == MOUSE_BUTTON_LEFT && !clicked_cell.held && obstacles[clicked_cell.loc.y][clicked_cell.loc.x] && mousex >= scroll_panel.x)
+                if(cell_is_clicked && clicked_cell.mouse_button == MOUSE_BUTTON_LEFT && !clicked_cell.held && grid_get_at(obstacles, cols, clicked_cell.loc) && mousex >= scroll_panel.x)
                 {
                     end.x = clicked_cell.loc.x;
                     end.y = clicked_cell.loc.y;
@@ -484,34 +866,93 @@ int main()
                     
                     // make cursor normal next frame, and clear path if it was drawn (since the grid was changed, the path might not apply anymore)
                     no_select();
-                    clear_path();
+                    path_changed();
                 }
                 break;
         }
         
-        // right click/hold will set/unset obstacles, as long as its not on Start/End
-        if(cell_is_clicked && !holding_same_obstacle_cell && clicked_cell.mouse_button == MOUSE_BUTTON_RIGHT && !locs_eq(clicked_cell.loc, start) && !locs_eq(clicked_cell.loc, end) && mousex >= scroll_panel.x && (!popup_open || !within_rect(mousex, mousey, popup_bounds)))
+        // right click starts a stroke, which sets/unsets obstacles but never on Start/End
+        if(!stroke.active && cell_is_clicked && !clicked_cell.held && clicked_cell.mouse_button == MOUSE_BUTTON_RIGHT && mousex >= scroll_panel.x && (!popup_open || !within_rect(mousex, mousey, popup_bounds)))
         {
-            obstacles[clicked_cell.loc.y][clicked_cell.loc.x] ^= 1; // set/unset obstacle
-            clear_path();
-            last_obstacle_changed = clicked_cell.loc;
+            // the path is invalidated once for the whole stroke, which also stops the search reading the obstacles
+            path_changed();
+            
+            stroke = (Obstacle_Stroke){
+                .active    = true,
+                .rectangle = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT),
+                .passable  = !grid_get_at(obstacles, cols, clicked_cell.loc),
+                .from = clicked_cell.loc,
+                .last = clicked_cell.loc
+            };
+            
+            // the brush paints the cell it starts on right away
+            if(!stroke.rectangle)
+            {
+                Cell_Rect changed = paint_obstacles(obstacles, cols, rows, stroke.from, stroke.last, brush_radius, stroke.passable, start, end);
+                if(changed.width != 0)
+                    mark_obstacles_dirty(&obstacles_texture, changed.x, changed.y, changed.width, changed.height);
+            }
+        }
+        else if(stroke.active && IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+        {
+            // the brush paints the line to the cell it's dragged to, so no cell is skipped when moving fast
+            // all the cells painted this frame are uploaded together
+            if(cell_is_clicked && clicked_cell.mouse_button == MOUSE_BUTTON_RIGHT && !locs_eq(clicked_cell.loc, stroke.last))
+            {
+                if(!stroke.rectangle)
+                {
+                    Cell_Rect changed = paint_obstacles(obstacles, cols, rows, stroke.last, clicked_cell.loc, brush_radius, stroke.passable, start, end);
+                    if(changed.width != 0)
+                        mark_obstacles_dirty(&obstacles_texture, changed.x, changed.y, changed.width, changed.height);
+                }
+                stroke.last = clicked_cell.loc;
+            }
+        }
+        else if(stroke.active)
+        {
+            // the rectangle is filled and uploaded at once when right click is released
+            if(stroke.rectangle)
+            {
+                Cell_Rect changed = fill_obstacles(obstacles, cols, rows, rect_between(stroke.from, stroke.last), stroke.passable, start, end);
+                if(changed.width != 0)
+                    mark_obstacles_dirty(&obstacles_texture, changed.x, changed.y, changed.width, changed.height);
+            }
+            stroke.active = false;
         }
         
+        // in live mode, find the path again once for all the changes of this frame, or of the stroke once it's done
+        // the search runs on the worker, so the frame only waits for the previous one to stop
+        if(live && live_changed && !stroke.active)
+        {
+            live_changed = false;
+            
+            if(within_grid(start, cols, rows) && within_grid(end, cols, rows))
+                start_search(&worker, obstacles, cols, rows, start, end);
+            else
+                clear_path();
+        }
+        
+        // the time is taken before EndDrawing, which waits for the next frame
+        struct timespec frame_end;
+        clock_gettime(CLOCK_MONOTONIC, &frame_end);
+        render_time = diff_timespec(frame_end, frame_begin);
+        
         EndDrawing();
     }
     
     // cleanup
-    for(int i = 0 ; i < arrlen(obstacles) ; i++)
-    {
-        arrfree(obstacles[i]);
-    }
-    arrfree(obstacles);
-    
+    free_search_worker(&worker);
+    free_search(&animation.search);
+    free(animation.texels);
+    UnloadTexture(animation.texture);
+    free(obstacles);
     free(path.locs);
+    free_path_spans(&path_spans);
+    UnloadTexture(obstacles_texture.texture);
     CloseWindow();
 }
 
-Cell_Click draw_grid(Vector2 topleft, int cols, int rows, Rectangle view, int panel_borderx)
+Cell_Click draw_grid(Vector2 topleft, int cols, int rows, int panel_borderx)
 {
     Cell_Click ret = {
         .loc  = null_loc,
@@ -563,87 +1004,38 @@ Cell_Click draw_grid(Vector2 topleft, int cols, int rows, Rectangle view, int pa
         }
     }
     
-    // drawing the rows
-    for(int i = (view.y - topleft.y) / (cell_size + line_thickness) ; i < rows + 1 && i < (view.y + view.height - topleft.y) / (cell_size + line_thickness) + line_thickness; i++)
-    {
-        Rectangle line = {
-            .x = topleft.x,
-            .y = topleft.y + (i * (cell_size + line_thickness)),
-            .width  = cols * (cell_size + line_thickness) + line_thickness,
-            .height = line_thickness
-        };
-        
-        DrawRectangleRec(line, BLACK);
-    }
-    
-    // drawing the cols
-    for(int i = (view.x - topleft.x) / (cell_size + line_thickness) ; i < cols + 1 && i < (view.x + view.width - topleft.x) / (cell_size + line_thickness) + line_thickness; i++)
-    {
-        Rectangle line = {
-            .x = topleft.x + (i * (cell_size + line_thickness)),
-            .y = topleft.y,
-            .width  = line_thickness,
-            .height = rows * (cell_size + line_thickness)
-        };
-        
-        DrawRectangleRec(line, BLACK);
-    }
-    
     return ret;
 }
 
-// grows/shrinks the obstacles grid according to the new rows/cols
-void resize_obstacles(bool ***obstacles, int cols, int rows)
+// grows/shrinks the obstacles grid according to the new rows/cols, keeping the obstacles that are still within it
+void resize_obstacles(bool **obstacles, int old_cols, int old_rows, int cols, int rows)
 {
-    int old_rows = arrlen(*obstacles);
-    int old_cols = arrlen((*obstacles)[0]);
-    
-    arrsetlen(*obstacles, rows);
+    const int kept_rows = old_rows < rows ? old_rows : rows;
     
-    // in case new rows is bigger, make new rows
-    for(int i = old_rows ; i < rows ; i++)
+    // in case new cols is smaller, move the rows to where they start now before shrinking, first to last so none is overwritten before it's moved
+    if(cols < old_cols)
     {
-        (*obstacles)[i] = NULL;
-        arrsetlen((*obstacles)[i], cols);
-        for(int j = 0 ; j < cols ; j++)
-        {
-            (*obstacles)[i][j] = true;
-        }
-    }
-    
-    for(int i = 0 ; i < rows ; i++)
-    {
-        arrsetlen((*obstacles)[i], cols);
-        
-        // in case new cols is bigger, make new cols
-        for(int j = old_cols ; j < cols ; j++)
-            (*obstacles)[i][j] = true;
+        for(int i = 1 ; i < kept_rows ; i++)
+            memmove(*obstacles + i * cols, *obstacles + i * old_cols, cols * sizeof(bool));
     }
     
-    // in case new rows is smaller, free old rows
-    for(int j = rows ; j < old_rows ; j++)
-    {
-        arrfree((*obstacles)[j]);
-        (*obstacles)[j] = NULL;
-    }
-}
-
-// returns a heap allocated 1D array from an array of bool arrays
-bool *obstacles_2d_to_1d(bool **obstacles)
-{
-    int rows = arrlen(obstacles);
-    int cols = arrlen(obstacles[0]);
+    *obstacles = realloc(*obstacles, rows * cols * sizeof(bool));
     
-    bool *ret = calloc(rows * cols, sizeof(bool));
-    for(int i = 0 ; i < rows ; i++)
+    // in case new cols is bigger, move the rows after growing, last to first, and make the new cols passable
+    if(cols > old_cols)
     {
-        for(int j = 0 ; j < cols ; j++)
+        for(int i = kept_rows - 1 ; i >= 0 ; i--)
         {
-            ret[i * cols + j] = obstacles[i][j];
+            memmove(*obstacles + i * cols, *obstacles + i * old_cols, old_cols * sizeof(bool));
+            memset(*obstacles + i * cols + old_cols, true, (cols - old_cols) * sizeof(bool));
         }
     }
     
-    return ret;
+    // in case new rows is bigger, make the new rows passable
+    if(rows > old_rows)
+    {
+        memset(*obstacles + old_rows * cols, true, (rows - old_rows) * cols * sizeof(bool));
+    }
 }
 
 // scrolls the grid if dragging it with mouse
@@ -677,25 +1069,18 @@ void move_popup_by_dragging_mouse(Rectangle *popup_bounds)
 }
 
 // returns the difference between two times as a double
-double diff_timespec(struct timespec time1, struct timespec time0) {
+double diff_timespec(struct timespec time1, struct timespec time0)
+{
   return (time1.tv_sec - time0.tv_sec)
       + (time1.tv_nsec - time0.tv_nsec) / 1000000000.0;
 }
 
-// calls the shortest path algorithm and sets the path
+// sets the path to the result of a finished search
 // sets the cost and time strings to reflect the result of the algorithm
-void set_path(Path *path, bool **obstacles, int cols, int rows, Loc start, Loc end, char *cost_str, char *time_str)
+void set_path(Path *path, Path result, Search_Stats stats, double time_taken, char *cost_str, char *time_str, char stats_str[STATS_LINES][64])
 {
-    bool *obstacles1d = obstacles_2d_to_1d(obstacles);
     free(path->locs);
-    
-    double before = GetTime();
-    *path = shortest_path(obstacles1d, cols, rows, start, end);
-    double after = GetTime();
-    
-    free(obstacles1d);
-    
-    double time_taken = after - before;
+    *path = result;
     
     // set the time string to the time taken
     sprintf(time_str, "Time: %.4lf", time_taken);
@@ -710,33 +1095,244 @@ void set_path(Path *path, bool **obstacles, int cols, int rows, Loc start, Loc e
     {
         sprintf(cost_str, "No Path");
     }
+    
+    // set the stats strings to what the search did
+    snprintf(stats_str[0], 64, "Expanded: %lld  Max queue: %d", stats.expanded, stats.max_queue_size);
+    snprintf(stats_str[1], 64, "Pushes: %lld  Pops: %lld  Decrease-keys: %lld", stats.pushes, stats.pops, stats.decrease_keys);
+#ifdef PATH_FINDER_STATS_TIME
+    snprintf(stats_str[2], 64, "Grid: %.3f  Reset: %.3f  Search: %.3f  Path: %.3f ms", stats.grid_ns / 1e6, stats.reset_ns / 1e6, stats.search_ns / 1e6, stats.path_ns / 1e6);
+#else
+    stats_str[2][0] = '\0';
+#endif
+#ifdef PATH_FINDER_STATS_OP_TIME
+    snprintf(stats_str[3], 64, "Expansion: %.3f ms  Queue: %.3f ms", stats.expand_ns / 1e6, (stats.push_ns + stats.pop_ns) / 1e6);
+#else
+    stats_str[3][0] = '\0';
+#endif
+}
+
+// adds the stats of a finished search to the timing history, dropping the oldest if it's full
+void record_timings(Timing_History *history, Search_Stats stats)
+{
+    history->searches[history->next] = stats;
+    history->next = (history->next + 1) % TIMING_HISTORY;
+    if(history->nb < TIMING_HISTORY)
+        history->nb++;
 }
 
-// draws the path as green squares on the grid, storing the path cells in the 'path_cells'
-void draw_path(Path path, Vector2 topleft)
+// draws the time the searches of the history spent on each phase as stacked bars, the most recent on the right
+// the grid pass in gray, the reset in orange, the expansions in blue and the path extraction in green
+void draw_timings(const Timing_History *history, Rectangle bounds)
 {
-    // if a path exists, draw it on the grid
-    if(path.locs != NULL)
+    DrawRectangleLinesEx(bounds, 1, LIGHTGRAY);
+    
+    if(history->nb == 0 || bounds.height <= 2)
+        return;
+    
+    // the bars are scaled so the slowest search of the history takes the whole height
+    long long max_ns = 1;
+    for(int i = 0 ; i < history->nb ; i++)
+    {
+        const Search_Stats *stats = &history->searches[i];
+        long long total_ns = stats->grid_ns + stats->reset_ns + stats->search_ns + stats->path_ns;
+        if(total_ns > max_ns)
+            max_ns = total_ns;
+    }
+    
+    const float bar_width = (bounds.width - 2) / TIMING_HISTORY;
+    const float height = bounds.height - 2;
+    const float bottom = bounds.y + bounds.height - 1;
+    
+    // the oldest search is drawn first, so the bars end at the right side once the history is full
+    const int oldest = history->nb < TIMING_HISTORY ? 0 : history->next;
+    for(int i = 0 ; i < history->nb ; i++)
     {
-        for(int i = 0 ; i < path.nb ; i++)
+        const Search_Stats *stats = &history->searches[(oldest + i) % TIMING_HISTORY];
+        const long long phases[4] = { stats->grid_ns, stats->reset_ns, stats->search_ns, stats->path_ns };
+        const Color colors[4] = { GRAY, ORANGE, SKYBLUE, GREEN };
+        
+        float x = bounds.x + 1 + (TIMING_HISTORY - history->nb + i) * bar_width;
+        float y = bottom;
+        for(int j = 0 ; j < 4 ; j++)
         {
-            // current cell to draw on the grid
-            Loc current = path.locs[i];
+            float phase_height = height * phases[j] / max_ns;
+            y -= phase_height;
+            DrawRectangleRec((Rectangle){ x, y, bar_width - 1, phase_height }, colors[j]);
+        }
+    }
+    
+    // the scale of the graph, at its top left
+    char max_str[32];
+    snprintf(max_str, sizeof(max_str), "%.3f ms", max_ns / 1e6);
+    GuiLabel((Rectangle){ bounds.x + 4, bounds.y + 2, bounds.width - 8, 24 }, max_str);
+}
+
+// draws the lines between the cells of the grid, as a tiled texture
+void draw_grid_lines(Vector2 topleft, int cols, int rows)
+{
+    // a texture of a single cell with the lines on its top and left sides, made again when zooming
+    static Texture2D tile = { 0 };
+    static int tile_cell_size = 0;
+    
+    const int pitch = cell_size + line_thickness;
+    
+    if(tile_cell_size != cell_size)
+    {
+        UnloadTexture(tile);
+        
+        Image image = GenImageColor(pitch, pitch, BLANK);
+        ImageDrawRectangle(&image, 0, 0, pitch, line_thickness, BLACK);
+        ImageDrawRectangle(&image, 0, 0, line_thickness, pitch, BLACK);
+        tile = LoadTextureFromImage(image);
+        UnloadImage(image);
+        
+        SetTextureWrap(tile, TEXTURE_WRAP_REPEAT);
+        tile_cell_size = cell_size;
+    }
+    
+    // the source is as big as the grid, so the tile repeats once per cell
+    Rectangle source = { 0, 0, cols * pitch, rows * pitch };
+    Rectangle dest   = { topleft.x, topleft.y, cols * pitch, rows * pitch };
+    DrawTexturePro(tile, source, dest, (Vector2){ 0, 0 }, 0, WHITE);
+    
+    // the tiles only have lines on their top and left sides, so the right and bottom lines are drawn apart
+    DrawRectangleRec((Rectangle){ topleft.x + cols * pitch, topleft.y, line_thickness, rows * pitch }, BLACK);
+    DrawRectangleRec((Rectangle){ topleft.x, topleft.y + rows * pitch, cols * pitch + line_thickness, line_thickness }, BLACK);
+}
+
+// compares two columns, for qsort
+static int compare_ints(const void *a, const void *b)
+{
+    return *(const int*) a - *(const int*) b;
+}
+
+// indexes the cells of the path by row, merging the cells next to each other into runs
+void index_path(Path_Spans *spans, Path path)
+{
+    spans->nb = 0;
+    spans->rows = 0;
+    
+    for(int i = 0 ; i < path.nb ; i++)
+    {
+        if(path.locs[i].y + 1 > spans->rows)
+            spans->rows = path.locs[i].y + 1;
+    }
+    
+    if(spans->rows == 0)
+        return;
+    
+    // the memory is only grown, a path is indexed every time one is found
+    if(spans->rows + 1 > spans->rows_cap)
+    {
+        spans->rows_cap = spans->rows + 1;
+        spans->row_first = realloc(spans->row_first, spans->rows_cap * sizeof(int));
+    }
+    if(path.nb > spans->xs_cap)
+    {
+        spans->xs_cap = path.nb;
+        spans->xs = realloc(spans->xs, spans->xs_cap * sizeof(int));
+    }
+    
+    // count the cells of each row, then make the counts the index of the first cell of each row
+    memset(spans->row_first, 0, (spans->rows + 1) * sizeof(int));
+    for(int i = 0 ; i < path.nb ; i++)
+        spans->row_first[path.locs[i].y + 1]++;
+    for(int y = 0 ; y < spans->rows ; y++)
+        spans->row_first[y + 1] += spans->row_first[y];
+    
+    // put the columns of the cells in their rows, each row_first ends up at the first cell of the next row
+    for(int i = 0 ; i < path.nb ; i++)
+        spans->xs[spans->row_first[path.locs[i].y]++] = path.locs[i].x;
+    for(int y = spans->rows ; y > 0 ; y--)
+        spans->row_first[y] = spans->row_first[y - 1];
+    spans->row_first[0] = 0;
+    
+    // the path has at most a cell per column of a row, the columns that follow each other are merged into a run
+    for(int y = 0 ; y < spans->rows ; y++)
+    {
+        const int first = spans->row_first[y];
+        const int last  = spans->row_first[y + 1];
+        
+        // row_first[y] is now the first run of the row, row_first[y + 1] is still the end of its cells
+        spans->row_first[y] = spans->nb;
+        
+        qsort(spans->xs + first, last - first, sizeof(int), compare_ints);
+        
+        for(int i = first ; i < last ; i++)
+        {
+            if(spans->nb > spans->row_first[y] && spans->spans[spans->nb - 1].x + spans->spans[spans->nb - 1].width == spans->xs[i])
+            {
+                spans->spans[spans->nb - 1].width++;
+                continue;
+            }
             
-            // this rectangle represents the coordinates and size of the cell
-            Rectangle path_cell_rect = {
-                .x = topleft.x + line_thickness + (current.x * (cell_size + line_thickness)),
-                .y = topleft.y + line_thickness + (current.y * (cell_size + line_thickness)),
-                .width  = cell_size,
+            if(spans->nb == spans->cap)
+            {
+                spans->cap = spans->cap ? spans->cap * 2 : 64;
+                spans->spans = realloc(spans->spans, spans->cap * sizeof(Cell_Rect));
+            }
+            spans->spans[spans->nb++] = (Cell_Rect){ spans->xs[i], y, 1, 1 };
+        }
+    }
+    spans->row_first[spans->rows] = spans->nb;
+}
+
+// draws the runs of the path that are within 'view' as green rectangles, covering the lines between their cells
+void draw_path(const Path_Spans *spans, Vector2 topleft, Rectangle view)
+{
+    if(spans->nb == 0)
+        return;
+    
+    const int pitch = cell_size + line_thickness;
+    
+    // the rows and columns of the cells that are at least partly in view
+    int first_row = iclampf((view.y - topleft.y) / pitch, 0, spans->rows - 1);
+    int last_row  = iclampf((view.y + view.height - topleft.y) / pitch, 0, spans->rows - 1);
+    int first_col = iclampf((view.x - topleft.x) / pitch, 0, INT_MAX);
+    int last_col  = iclampf((view.x + view.width - topleft.x) / pitch, 0, INT_MAX);
+    
+    for(int y = first_row ; y <= last_row ; y++)
+    {
+        // the first run of the row that ends in view, the runs of a row are sorted and don't overlap
+        int lo = spans->row_first[y];
+        int hi = spans->row_first[y + 1];
+        while(lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+            if(spans->spans[mid].x + spans->spans[mid].width <= first_col)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        
+        for(int i = lo ; i < spans->row_first[y + 1] && spans->spans[i].x <= last_col ; i++)
+        {
+            // only the part of the run in view is drawn
+            int x0 = spans->spans[i].x > first_col ? spans->spans[i].x : first_col;
+            int x1 = spans->spans[i].x + spans->spans[i].width - 1 < last_col ? spans->spans[i].x + spans->spans[i].width - 1 : last_col;
+            
+            // this rectangle covers the cells of the run and the lines between them
+            Rectangle run_rect = {
+                .x = topleft.x + line_thickness + (x0 * pitch),
+                .y = topleft.y + line_thickness + (y * pitch),
+                .width  = (x1 - x0 + 1) * pitch - line_thickness,
                 .height = cell_size
             };
             
-            // draw the path cell as GREEN
-            DrawRectangleRec(path_cell_rect, GREEN);
+            DrawRectangleRec(run_rect, GREEN);
         }
     }
 }
 
+// frees the memory of the path index
+void free_path_spans(Path_Spans *spans)
+{
+    free(spans->spans);
+    free(spans->row_first);
+    free(spans->xs);
+    *spans = (Path_Spans){ 0 };
+}
+
 bool draw_spinners_and_update_rows_cols(Rectangle r_spinner, Rectangle c_spinner, int *rows, int *cols)
 {
     static bool edit_rows = false;
@@ -798,39 +1394,306 @@ bool draw_spinners(Rectangle r_spinner, Rectangle c_spinner, int rows, int cols)
     return false;
 }
 
-// draws the obstacles on the grid as red squares
-void draw_obstacles(bool **obstacles, int cols, int rows, Vector2 topleft, Rectangle view)
+// grows a rectangle of cells so it also holds another one
+void grow_cell_rect(Cell_Rect *rect, int x, int y, int width, int height)
 {
-    // draw the obstacles that are in view
-    for(int i = (view.y - topleft.y) / (cell_size + line_thickness) ; i < rows && i < (view.y + view.height - topleft.y) / (cell_size + line_thickness) + line_thickness ; i++)
+    if(rect->width == 0)
     {
-        for(int j = (view.x - topleft.x) / (cell_size + line_thickness) ; j < cols && j < (view.x + view.width - topleft.x) / (cell_size + line_thickness) + line_thickness ; j++)
+        *rect = (Cell_Rect){ x, y, width, height };
+        return;
+    }
+    
+    int right  = x + width  > rect->x + rect->width  ? x + width  : rect->x + rect->width;
+    int bottom = y + height > rect->y + rect->height ? y + height : rect->y + rect->height;
+    rect->x = x < rect->x ? x : rect->x;
+    rect->y = y < rect->y ? y : rect->y;
+    rect->width  = right  - rect->x;
+    rect->height = bottom - rect->y;
+}
+
+// marks cells of the obstacles texture as changed, so they're uploaded before it's drawn
+void mark_obstacles_dirty(Obstacles_Texture *texture, int x, int y, int width, int height)
+{
+    grow_cell_rect(&texture->dirty, x, y, width, height);
+}
+
+// uploads the changed cells to the obstacles texture, making a new texture if the grid was resized
+void upload_obstacles(Obstacles_Texture *texture, const bool *obstacles, int cols, int rows)
+{
+    if(texture->cols != cols || texture->rows != rows)
+    {
+        UnloadTexture(texture->texture);
+        
+        // a gray and alpha texel per cell, tinted when drawn. Passable cells are transparent
+        Image image = {
+            .data    = malloc(cols * rows * 2),
+            .width   = cols,
+            .height  = rows,
+            .mipmaps = 1,
+            .format  = PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA
+        };
+        texture->texture = LoadTextureFromImage(image);
+        free(image.data);
+        
+        texture->cols = cols;
+        texture->rows = rows;
+        texture->dirty = (Cell_Rect){ 0, 0, cols, rows };
+    }
+    
+    if(texture->dirty.width == 0)
+        return;
+    
+    // the texels of the changed cells, in a buffer that's only grown
+    static unsigned char *texels = NULL;
+    static int texels_cap = 0;
+    
+    const int x = texture->dirty.x;
+    const int y = texture->dirty.y;
+    const int width  = texture->dirty.width;
+    const int height = texture->dirty.height;
+    
+    if(width * height * 2 > texels_cap)
+    {
+        texels_cap = width * height * 2;
+        texels = realloc(texels, texels_cap);
+    }
+    
+    for(int i = 0 ; i < height ; i++)
+    {
+        for(int j = 0 ; j < width ; j++)
+        {
+            unsigned char blocked = obstacles[(y + i) * cols + x + j] ? 0 : 255;
+            texels[2 * (i * width + j)]     = blocked;
+            texels[2 * (i * width + j) + 1] = blocked;
+        }
+    }
+    
+    UpdateTextureRec(texture->texture, (Rectangle){ x, y, width, height }, texels);
+    texture->dirty.width = 0;
+}
+
+// draws the obstacles on the grid as red squares, with a single quad
+void draw_obstacles(const Obstacles_Texture *texture, Vector2 topleft)
+{
+    const int pitch = cell_size + line_thickness;
+    
+    // each texel covers a cell and the lines on its right and bottom, which are drawn over it
+    Rectangle source = { 0, 0, texture->cols, texture->rows };
+    Rectangle dest = {
+        .x = topleft.x + line_thickness,
+        .y = topleft.y + line_thickness,
+        .width  = texture->cols * pitch,
+        .height = texture->rows * pitch
+    };
+    
+    DrawTexturePro(texture->texture, source, dest, (Vector2){ 0, 0 }, 0, RED);
+}
+
+// the colors of the cells of an animated search
+#define ANIMATION_VISITED  (Color){ 102, 191, 255, 160 }
+#define ANIMATION_FRONTIER (Color){ 253, 249, 0, 200 }
+#define ANIMATION_PATH     GREEN
+
+// starts showing a search from start to end, the obstacles must not change until it's stopped
+void start_animation(Search_Animation *animation, const bool *obstacles, int cols, int rows, Loc start, Loc end)
+{
+    // a new texture is made if the grid was resized
+    if(animation->cols != cols || animation->rows != rows)
+    {
+        UnloadTexture(animation->texture);
+        animation->texels = realloc(animation->texels, cols * rows * sizeof(Color));
+        
+        Image image = {
+            .data    = animation->texels,
+            .width   = cols,
+            .height  = rows,
+            .mipmaps = 1,
+            .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        };
+        animation->texture = LoadTextureFromImage(image);
+        
+        animation->cols = cols;
+        animation->rows = rows;
+    }
+    
+    // all the cells start transparent, and are all uploaded
+    memset(animation->texels, 0, cols * rows * sizeof(Color));
+    animation->dirty = (Cell_Rect){ 0, 0, cols, rows };
+    
+    search_begin(&animation->search, obstacles, cols, rows, start, end);
+    animation->time_taken = 0;
+    animation->running = true;
+    animation->shown = true;
+}
+
+// expands up to 'expansions' cells of the animated search and colors them
+// returns true once when the search is done, with its path in 'result'
+bool step_animation(Search_Animation *animation, long long expansions, Path *result)
+{
+    if(!animation->running)
+        return false;
+    
+    Search *search = &animation->search;
+    const int cols = animation->cols;
+    const int rows = animation->rows;
+    
+    double before = GetTime();
+    
+    // the search is stepped one cell at a time, to color the expanded cell and its neighbours
+    Search_Status status = search->status;
+    for(long long i = 0 ; i < expansions && status == SEARCH_RUNNING ; i++)
+    {
+        status = search_step(search, 1);
+        
+        Loc loc = search->expanded_loc;
+        if(locs_eq(loc, null_loc))
+            continue;
+        
+        int x0 = loc.x > 0 ? loc.x - 1 : 0;
+        int y0 = loc.y > 0 ? loc.y - 1 : 0;
+        int x1 = loc.x < cols - 1 ? loc.x + 1 : cols - 1;
+        int y1 = loc.y < rows - 1 ? loc.y + 1 : rows - 1;
+        
+        // the neighbours that are in the queue are the frontier
+        for(int y = y0 ; y <= y1 ; y++)
         {
-            if(!obstacles[i][j])
+            for(int x = x0 ; x <= x1 ; x++)
             {
-                Rectangle obstacle_rect = {
-                    .x = topleft.x + line_thickness + (j * (cell_size + line_thickness)),
-                    .y = topleft.y + line_thickness + (i * (cell_size + line_thickness)),
-                    .width  = cell_size,
-                    .height = cell_size
-                };
-                
-                DrawRectangleRec(obstacle_rect, RED);
+                if(search->cells[y * cols + x].enqueued)
+                    animation->texels[y * cols + x] = ANIMATION_FRONTIER;
             }
         }
+        
+        animation->texels[loc.y * cols + loc.x] = ANIMATION_VISITED;
+        grow_cell_rect(&animation->dirty, x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+    }
+    
+    animation->time_taken += GetTime() - before;
+    
+    if(status == SEARCH_RUNNING)
+        return false;
+    
+    // color the path over the cells that were expanded
+    stats_time(&search->stats, path_ns, *result = search_path(search));
+    for(int i = 0 ; i < result->nb ; i++)
+    {
+        Loc loc = result->locs[i];
+        animation->texels[loc.y * cols + loc.x] = ANIMATION_PATH;
+        grow_cell_rect(&animation->dirty, loc.x, loc.y, 1, 1);
     }
+    
+    animation->running = false;
+    return true;
+}
+
+// stops the animated search and stops drawing it
+void stop_animation(Search_Animation *animation)
+{
+    animation->running = false;
+    animation->shown = false;
+}
+
+// uploads the changed cells of the animated search and draws it over the grid, with a single quad
+void draw_animation(Search_Animation *animation, Vector2 topleft)
+{
+    if(!animation->shown)
+        return;
+    
+    // the changed rows are uploaded whole, since they're contiguous in the texels
+    if(animation->dirty.width != 0)
+    {
+        Rectangle rows_rect = { 0, animation->dirty.y, animation->cols, animation->dirty.height };
+        UpdateTextureRec(animation->texture, rows_rect, animation->texels + animation->dirty.y * animation->cols);
+        animation->dirty.width = 0;
+    }
+    
+    const int pitch = cell_size + line_thickness;
+    
+    Rectangle source = { 0, 0, animation->cols, animation->rows };
+    Rectangle dest = {
+        .x = topleft.x + line_thickness,
+        .y = topleft.y + line_thickness,
+        .width  = animation->cols * pitch,
+        .height = animation->rows * pitch
+    };
+    
+    DrawTexturePro(animation->texture, source, dest, (Vector2){ 0, 0 }, 0, WHITE);
 }
 
 // removes all the obstacles from the grid
-void clear_obstacles(bool ***obstacles, int cols, int rows)
+void clear_obstacles(bool *obstacles, int cols, int rows)
 {
-    for(int i = 0 ; i < rows ; i++)
+    memset(obstacles, true, rows * cols * sizeof(bool));
+}
+
+// sets the cells of a rectangle to passable or not, a row at a time, keeping Start and End passable
+// returns the part of the rectangle within the grid, which is what changed
+Cell_Rect fill_obstacles(bool *obstacles, int cols, int rows, Cell_Rect rect, bool passable, Loc start, Loc end)
+{
+    int x0 = rect.x > 0 ? rect.x : 0;
+    int y0 = rect.y > 0 ? rect.y : 0;
+    int x1 = rect.x + rect.width  < cols ? rect.x + rect.width  : cols;
+    int y1 = rect.y + rect.height < rows ? rect.y + rect.height : rows;
+    
+    if(x0 >= x1 || y0 >= y1)
+        return (Cell_Rect){ 0 };
+    
+    for(int y = y0 ; y < y1 ; y++)
+        memset(obstacles + y * cols + x0, passable, (x1 - x0) * sizeof(bool));
+    
+    // Start/End can't be on an obstacle
+    if(within_grid(start, cols, rows))
+        grid_get_at(obstacles, cols, start) = true;
+    if(within_grid(end, cols, rows))
+        grid_get_at(obstacles, cols, end) = true;
+    
+    return (Cell_Rect){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+// paints a square brush of 'radius' cells around each cell of the line from 'from' to 'to'
+// returns the rectangle holding all the cells that changed
+Cell_Rect paint_obstacles(bool *obstacles, int cols, int rows, Loc from, Loc to, int radius, bool passable, Loc start, Loc end)
+{
+    Cell_Rect changed = { 0 };
+    
+    // the line goes one cell at a time along its longest side
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+    
+    for(int i = 0 ; i <= steps ; i++)
     {
-        for(int j = 0 ; j < cols ; j++)
-        {
-            (*obstacles)[i][j] = true;
-        }
+        // the cell of the line at step i, rounded to the nearest
+        int x = steps == 0 ? from.x : from.x + (2 * dx * i + (dx >= 0 ? steps : -steps)) / (2 * steps);
+        int y = steps == 0 ? from.y : from.y + (2 * dy * i + (dy >= 0 ? steps : -steps)) / (2 * steps);
+        
+        Cell_Rect brush = { x - radius, y - radius, 2 * radius + 1, 2 * radius + 1 };
+        Cell_Rect filled = fill_obstacles(obstacles, cols, rows, brush, passable, start, end);
+        if(filled.width != 0)
+            grow_cell_rect(&changed, filled.x, filled.y, filled.width, filled.height);
     }
+    
+    return changed;
+}
+
+// returns the rectangle of cells between two corners, both included
+Cell_Rect rect_between(Loc l1, Loc l2)
+{
+    int x = l1.x < l2.x ? l1.x : l2.x;
+    int y = l1.y < l2.y ? l1.y : l2.y;
+    return (Cell_Rect){ x, y, abs(l1.x - l2.x) + 1, abs(l1.y - l2.y) + 1 };
+}
+
+// returns the bounds of a rectangle of cells on the screen, without the lines around it
+Rectangle screen_rect(Cell_Rect rect, Vector2 topleft)
+{
+    const int pitch = cell_size + line_thickness;
+    return (Rectangle){
+        .x = topleft.x + line_thickness + rect.x * pitch,
+        .y = topleft.y + line_thickness + rect.y * pitch,
+        .width  = rect.width  * pitch - line_thickness,
+        .height = rect.height * pitch - line_thickness
+    };
 }
 
 // clamps a float between 2 int values
@@ -1,8 +1,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 #include "../include/path_finder.h"
 #include "../include/priority_queue.h"
+#include "../include/search.h"
 
 // Returns true if l1 is the same location as l2
 bool locs_eq(Loc l1, Loc l2)
@@ -69,8 +71,11 @@ static Loc cell_ptr_to_loc(const Cell *cell, int cols, const Cell *grid)
 
 // Enqueues in the given queue the adjacenet cells to the current cell
 // Ignoring unpassable cells and cells that were already visited and cells that are too expensive
-static void enqueue_unvisited_passable_adjacents_if_cheaper(const Cell *current, int cols, int rows, const bool *obstacle_grid, Cell *cell_grid, Loc start, Priority_Queue *unexpanded)
+static void enqueue_unvisited_passable_adjacents_if_cheaper(const Cell *current, int cols, int rows, const bool *obstacle_grid, Cell *cell_grid, Loc start, Priority_Queue *unexpanded, Search_Stats *stats)
 {
+    // only used when the stats are counted
+    (void) stats;
+    
     Loc current_loc = cell_ptr_to_loc(current, cols, cell_grid);
     
     Loc up         = (Loc){.x = current_loc.x,     .y = current_loc.y - 1};
@@ -139,7 +144,11 @@ static void enqueue_unvisited_passable_adjacents_if_cheaper(const Cell *current,
                 /* set the number of steps it took to reach the cell */                   \
                 grid_get_at(cell_grid, cols, locs[adj]).nb_steps = current->nb_steps + 1; \
                                                                                           \
-                enqueue(unexpanded, &grid_get_at(cell_grid, cols, locs[adj]));            \
+                /* a cell already in the queue only has its cost decreased */              \
+                stats_add(stats, decrease_keys, grid_get_at(cell_grid, cols, locs[adj]).enqueued != 0); \
+                stats_add(stats, pushes, grid_get_at(cell_grid, cols, locs[adj]).enqueued == 0); \
+                stats_op_time(stats, push_ns, enqueue(unexpanded, &grid_get_at(cell_grid, cols, locs[adj]))); \
+                stats_max(stats, max_queue_size, unexpanded->size);                       \
             }                                                                             \
         }                                                                                 \
     } while(0)
@@ -157,68 +166,189 @@ static void enqueue_unvisited_passable_adjacents_if_cheaper(const Cell *current,
     #undef enqueue_adjacent
 }
 
+#ifdef PATH_FINDER_STATS_TIME
+long long stats_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#endif
+
 Path shortest_path(const bool *obstacle_grid, int cols, int rows, Loc start, Loc end)
 {
-    // if the start/end is not passable, return NULL
-    if(!grid_get_at(obstacle_grid, cols, end) || !grid_get_at(obstacle_grid, cols, start))
+    return shortest_path_with_stats(obstacle_grid, cols, rows, start, end, NULL);
+}
+
+Path shortest_path_with_stats(const bool *obstacle_grid, int cols, int rows, Loc start, Loc end, Search_Stats *out_stats)
+{
+    // a search of its own, so callers on different threads don't share anything
+    Search search = { 0 };
+    Path path = shortest_path_controlled(&search, obstacle_grid, cols, rows, start, end, out_stats, NULL);
+    free_search(&search);
+    
+    return path;
+}
+
+// the number of expansions between two checks of the search control
+#define CONTROL_INTERVAL 1024
+
+Path shortest_path_controlled(Search *search, const bool *obstacle_grid, int cols, int rows, Loc start, Loc end, Search_Stats *out_stats, Search_Control *control)
+{
+    search_begin(search, obstacle_grid, cols, rows, start, end);
+    
+    // publish the progress and stop if cancelled every few expansions
+    while(search_step(search, CONTROL_INTERVAL) == SEARCH_RUNNING)
     {
-        return (Path){0};
+        if(control == NULL)
+            continue;
+        
+        atomic_store_explicit(&control->expanded, search->expanded, memory_order_relaxed);
+        if(atomic_load_explicit(&control->cancel, memory_order_relaxed))
+        {
+            if(out_stats != NULL)
+                *out_stats = search->stats;
+            return (Path){0};
+        }
     }
     
-    static Cell *cell_grid = NULL;
-    static int old_rows = 0;
-    static int old_cols = 0;
+    if(control != NULL)
+        atomic_store_explicit(&control->expanded, search->expanded, memory_order_relaxed);
+    
+    Path path;
+    stats_time(&search->stats, path_ns, path = search_path(search));
+    
+    if(out_stats != NULL)
+        *out_stats = search->stats;
+    
+    return path;
+}
+
+// clears the state left by the last search, growing its memory if the grid is bigger
+static void reset_search(Search *search)
+{
+    const int cells = search->rows * search->cols;
     
     // reallocate for the cell grid if it's not big enough
-    if(old_rows < rows || old_cols < cols)
+    if(cells > search->cells_cap)
     {
-        cell_grid = realloc(cell_grid, rows * cols * sizeof(Cell));
+        search->cells_cap = cells;
+        search->cells = realloc(search->cells, search->cells_cap * sizeof(Cell));
     }
     
     // setting the parents to UNKNOWN and enqueued to 0
-    memset(cell_grid, 0, rows * cols * sizeof(Cell));
+    memset(search->cells, 0, cells * sizeof(Cell));
     
-    old_rows = rows;
-    old_cols = cols;
+    init_queue(&search->unexpanded, cells);
+}
+
+void search_begin(Search *search, const bool *grid, int cols, int rows, Loc start, Loc end)
+{
+    search->grid  = grid;
+    search->cols  = cols;
+    search->rows  = rows;
+    search->start = start;
+    search->end   = end;
+    search->expanded = 0;
+    search->expanded_loc = null_loc;
+    search->stats = (Search_Stats){0};
     
-    // the cost from end to end is 0, and end has no NONE parent
-    grid_get_at(cell_grid, cols, end).parent_dir = NONE;
+    // if the start/end is not passable, there's no path
+    if(!grid_get_at(grid, cols, end) || !grid_get_at(grid, cols, start))
+    {
+        search->status = SEARCH_NOT_FOUND;
+        return;
+    }
     
-    static Priority_Queue unexpanded = { 0 };
+    stats_time(&search->stats, reset_ns, reset_search(search));
     
-    init_queue(&unexpanded, rows * cols);
+    // the cost from end to end is 0, and end has no NONE parent
+    grid_get_at(search->cells, cols, end).parent_dir = NONE;
     
     // enqueue the end
-    enqueue(&unexpanded, &grid_get_at(cell_grid, cols, end));
+    enqueue(&search->unexpanded, &grid_get_at(search->cells, cols, end));
+    stats_add(&search->stats, pushes, 1);
+    stats_max(&search->stats, max_queue_size, search->unexpanded.size);
     
-    // until the queue is emptied, keep dequeuing
-    while(unexpanded.size != 0)
+    search->status = SEARCH_RUNNING;
+}
+
+// expands up to 'max_expansions' cells of a running search, see search_step
+static void expand_cells(Search *search, long long max_expansions)
+{
+    const int cols = search->cols;
+    Cell *start_cell = &grid_get_at(search->cells, cols, search->start);
+    
+    for(long long i = 0 ; i < max_expansions && search->status == SEARCH_RUNNING ; i++)
     {
-        Cell *current = dequeue(&unexpanded);
+        // if the queue is emptied before start is expanded, start can't be reached
+        if(search->unexpanded.size == 0)
+        {
+            search->status = SEARCH_NOT_FOUND;
+            break;
+        }
+        
+        Cell *current;
+        stats_op_time(&search->stats, pop_ns, current = dequeue(&search->unexpanded));
+        stats_add(&search->stats, pops, 1);
         current->visited = true;
+        stats_add(&search->stats, expanded, 1);
+        search->expanded++;
+        search->expanded_loc = cell_ptr_to_loc(current, cols, search->cells);
         
-        enqueue_unvisited_passable_adjacents_if_cheaper(current, cols, rows, obstacle_grid, cell_grid, start, &unexpanded);
+        // the cost of start is final once it's expanded, the cells left in the queue can't make it cheaper
+        if(current == start_cell)
+        {
+            search->status = SEARCH_FOUND;
+            break;
+        }
+        
+        stats_op_time(&search->stats, expand_ns, enqueue_unvisited_passable_adjacents_if_cheaper(current, cols, search->rows, search->grid, search->cells, search->start, &search->unexpanded, &search->stats));
     }
+}
+
+Search_Status search_step(Search *search, long long max_expansions)
+{
+    if(search->status != SEARCH_RUNNING)
+        return search->status;
     
-    // if the start point still has UNKNOWN parent, it means no path was found. Return NULL
-    if(grid_get_at(cell_grid, cols, start).parent_dir == UNKNOWN)
-    {
+    stats_time(&search->stats, search_ns, expand_cells(search, max_expansions));
+    
+    // the pushes are timed within the expansions, so their time is taken out of it once done
+    if(search->status != SEARCH_RUNNING)
+        stats_add(&search->stats, expand_ns, -search->stats.push_ns);
+    
+    return search->status;
+}
+
+Path search_path(const Search *search)
+{
+    if(search->status != SEARCH_FOUND)
         return (Path){0};
-    }
+    
+    const int cols = search->cols;
+    const Cell *start_cell = &grid_get_at(search->cells, cols, search->start);
     
     // allocate for a path, which is just a cost with an array of locations
-    Path path = { 0 }; 
-    path.locs = (Loc*) malloc(sizeof(Loc) * (grid_get_at(cell_grid, cols, start).nb_steps + 1));
-    path.nb   = grid_get_at(cell_grid, cols, start).nb_steps + 1;
-    path.cost = grid_get_at(cell_grid, cols, start).cost;
+    Path path = { 0 };
+    path.locs = (Loc*) malloc(sizeof(Loc) * (start_cell->nb_steps + 1));
+    path.nb   = start_cell->nb_steps + 1;
+    path.cost = start_cell->cost;
     
     // fill the path with the locations of the cells in the path from start to end
-    Loc loc_iter = start;
+    Loc loc_iter = search->start;
     for(int i = 0 ; i < path.nb ; i++)
     {
         path.locs[i] = loc_iter;
-        loc_iter = next_loc(loc_iter, grid_get_at(cell_grid, cols, loc_iter).parent_dir);
+        loc_iter = next_loc(loc_iter, grid_get_at(search->cells, cols, loc_iter).parent_dir);
     }
     
     return path;
 }
+
+void free_search(Search *search)
+{
+    free(search->cells);
+    free(search->unexpanded.data);
+    *search = (Search){0};
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <time.h>
+#include "../include/search_worker.h"
+
+// returns a monotonic time in seconds
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+// the body of the search thread, runs a single search and marks it done
+static void *run_search(void *arg)
+{
+    Search_Worker *worker = (Search_Worker*) arg;
+    
+    // the search fills the stats, the time spent on the grid before it was measured when it was started
+    const long long grid_ns = worker->stats.grid_ns;
+    
+    double before = now_seconds();
+    worker->path = shortest_path_controlled(&worker->search, worker->grid, worker->cols, worker->rows, worker->start, worker->end, &worker->stats, &worker->control);
+    worker->time_taken = now_seconds() - before;
+    worker->stats.grid_ns = grid_ns;
+    
+    // the result is written before done is set, so whoever sees done sees the result
+    atomic_store_explicit(&worker->done, true, memory_order_release);
+    return NULL;
+}
+
+// returns the number of passable cells of the obstacles
+static long long count_passable(const bool *obstacles, int cells)
+{
+    long long passable = 0;
+    for(int i = 0 ; i < cells ; i++)
+        passable += obstacles[i];
+    
+    return passable;
+}
+
+// waits for the search thread, unless the search ran on this thread
+static void join_search(Search_Worker *worker)
+{
+    if(!pthread_equal(worker->thread, pthread_self()))
+        pthread_join(worker->thread, NULL);
+    worker->running = false;
+}
+
+void start_search(Search_Worker *worker, const bool *obstacles, int cols, int rows, Loc start, Loc end)
+{
+    cancel_search(worker);
+    
+    worker->stats = (Search_Stats){0};
+    stats_time(&worker->stats, grid_ns, worker->passable = count_passable(obstacles, rows * cols));
+    
+    worker->grid  = obstacles;
+    worker->cols  = cols;
+    worker->rows  = rows;
+    worker->start = start;
+    worker->end   = end;
+    worker->path  = (Path){0};
+    
+    atomic_store(&worker->control.cancel, false);
+    atomic_store(&worker->control.expanded, 0);
+    atomic_store(&worker->done, false);
+    
+    // if no thread could be made, search on this one so the path is still found
+    if(pthread_create(&worker->thread, NULL, run_search, worker) != 0)
+    {
+        run_search(worker);
+        worker->thread = pthread_self();
+    }
+    worker->running = true;
+}
+
+void cancel_search(Search_Worker *worker)
+{
+    if(!worker->running)
+        return;
+    
+    atomic_store(&worker->control.cancel, true);
+    join_search(worker);
+    
+    free(worker->path.locs);
+    worker->path = (Path){0};
+}
+
+bool search_finished(Search_Worker *worker)
+{
+    if(!worker->running || !atomic_load_explicit(&worker->done, memory_order_acquire))
+        return false;
+    
+    join_search(worker);
+    return true;
+}
+
+bool search_running(const Search_Worker *worker)
+{
+    return worker->running;
+}
+
+float search_progress(Search_Worker *worker)
+{
+    if(worker->passable == 0)
+        return 0;
+    
+    // the search expands every cell it can reach, so the passable cells are the most it can take
+    return (float) atomic_load_explicit(&worker->control.expanded, memory_order_relaxed) / worker->passable;
+}
+
+void free_search_worker(Search_Worker *worker)
+{
+    cancel_search(worker);
+    free_search(&worker->search);
+    *worker = (Search_Worker){0};
+}